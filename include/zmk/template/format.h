@@ -0,0 +1,51 @@
+/**
+ * Template Feature - Allocation-free string formatting
+ *
+ * Builds response strings into fixed buffers without the printf family, so
+ * handlers do not pull it into size-constrained builds. Output is truncated
+ * to the buffer and always NUL-terminated.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Buffer size that fits any int32_t or uint32_t in decimal, including the
+ * sign and the terminating NUL.
+ */
+#define ZMK_TEMPLATE_ITOA_BUF_SIZE 12
+
+/**
+ * Write `value` in decimal to `out`, which must hold
+ * ZMK_TEMPLATE_ITOA_BUF_SIZE bytes. Returns the length without the NUL.
+ */
+size_t zmk_template_utoa(uint32_t value, char *out);
+size_t zmk_template_itoa(int32_t value, char *out);
+
+struct zmk_template_fmt {
+  char *buf;
+  size_t size;
+  size_t len;
+  // Set once output was cut short to fit `size`
+  bool truncated;
+};
+
+/**
+ * Start formatting into `buf` of `size` bytes, e.g. a nanopb string field.
+ */
+void zmk_template_fmt_init(struct zmk_template_fmt *fmt, char *buf,
+                           size_t size);
+
+void zmk_template_fmt_str(struct zmk_template_fmt *fmt, const char *str);
+void zmk_template_fmt_int(struct zmk_template_fmt *fmt, int32_t value);
+void zmk_template_fmt_uint(struct zmk_template_fmt *fmt, uint32_t value);
+
+/**
+ * Length of the string built so far, without the NUL.
+ */
+static inline size_t zmk_template_fmt_len(const struct zmk_template_fmt *fmt) {
+  return fmt->len;
+}
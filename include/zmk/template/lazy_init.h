@@ -0,0 +1,68 @@
+/**
+ * Template Feature - Lazy initialization
+ *
+ * State the module only needs while the web UI is in use is set up on first
+ * use instead of at boot, so boot-to-first-keypress time does not grow with
+ * the module's features. Initializers registered with
+ * ZMK_TEMPLATE_LAZY_INIT() run once, either from the first use that calls
+ * ZMK_TEMPLATE_LAZY_INIT_ENSURE(), or all together before the first RPC is
+ * handled, whichever comes first. With
+ * CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_LAZY_INIT_WARM_UP_ON_UNLOCK they
+ * also run when ZMK Studio is unlocked with &studio_unlock, if that happens
+ * first.
+ *
+ * Settings stay with ZMK's settings load at boot: it reads the storage in one
+ * pass, and a subtree loaded later would read it again.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/iterable_sections.h>
+
+struct z_template_lazy_init_state {
+  atomic_t done;
+  int rc;
+};
+
+struct zmk_template_lazy_init {
+  const char *name;
+  // Return 0, or a negative errno that is returned by every later ensure
+  int (*init)(void);
+  // Kept in RAM, the entries themselves are in ROM
+  struct z_template_lazy_init_state *state;
+};
+
+/**
+ * Register `init_fn`, `int init_fn(void)`, to set up `id` on first use.
+ * It runs on the thread of that use, never from an ISR, and must not depend
+ * on other lazy initializers running before it unless it ensures them.
+ * Registering the same name twice fails to link.
+ */
+#define ZMK_TEMPLATE_LAZY_INIT(id, init_fn)                                    \
+  static struct z_template_lazy_init_state z_template_lazy_init_state_##id;    \
+  STRUCT_SECTION_ITERABLE(zmk_template_lazy_init,                              \
+                          zmk_template_lazy_init_##id) = {                     \
+      .name = #id,                                                             \
+      .init = init_fn,                                                         \
+      .state = &z_template_lazy_init_state_##id,                               \
+  }
+
+/**
+ * Run the initializer of `id` unless it ran already, from the file that
+ * registered it. Cheap once done, so it can guard every entry point.
+ *
+ * @return The result of the initializer.
+ */
+#define ZMK_TEMPLATE_LAZY_INIT_ENSURE(id)                                      \
+  zmk_template_lazy_init_ensure(&zmk_template_lazy_init_##id)
+
+int zmk_template_lazy_init_ensure(const struct zmk_template_lazy_init *entry);
+
+/**
+ * Run every initializer that did not run yet. Called before the first RPC is
+ * handled; returns at once afterwards.
+ */
+void zmk_template_lazy_init_all(void);
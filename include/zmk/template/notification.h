@@ -0,0 +1,61 @@
+/**
+ * Template Feature - Notifications
+ *
+ * Pushes Notification messages to the web UI without a preceding request.
+ */
+
+#pragma once
+
+#include <errno.h>
+
+#include <zephyr/sys/util.h>
+
+#include <zmk/template/custom.pb.h>
+
+#if IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_NOTIFICATIONS)
+
+/**
+ * Queue `notification` for sending. It is encoded immediately, so the caller
+ * may reuse it once this returns. Safe to call from any thread.
+ *
+ * Notifications are sent after a short window
+ * (CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_NOTIFICATION_COALESCE_MS). If one of
+ * the same kind is still waiting, it is replaced, so only the latest state is
+ * sent. Use zmk_template_notify_no_coalesce() for events that must all be
+ * delivered.
+ *
+ * `notification->qos` picks how it may be delayed: QOS_URGENT skips the
+ * window, and QOS_BULK is held while the keyboard is idle on battery (see
+ * CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_POWER_SAVE).
+ *
+ * Notifications are only delivered once the web UI has contacted the
+ * subsystem, since that is when its Studio subsystem index becomes known.
+ *
+ * @retval 0 Queued.
+ * @retval -ENOTCONN No web UI has contacted the subsystem yet.
+ * @retval -ENOMEM The queue is full.
+ * @retval -EINVAL The notification could not be encoded.
+ * @retval -EMSGSIZE The notification does not fit a Studio notification.
+ * @retval -ENOTSUP Notifications are disabled in Kconfig.
+ */
+int zmk_template_notify(const zmk_template_Notification *notification);
+
+/**
+ * Like zmk_template_notify(), but never merged with other notifications.
+ */
+int zmk_template_notify_no_coalesce(
+    const zmk_template_Notification *notification);
+
+#else
+
+static inline int
+zmk_template_notify(const zmk_template_Notification *notification) {
+  return -ENOTSUP;
+}
+
+static inline int
+zmk_template_notify_no_coalesce(const zmk_template_Notification *notification) {
+  return -ENOTSUP;
+}
+
+#endif
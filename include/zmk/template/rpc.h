@@ -0,0 +1,147 @@
+/**
+ * Template Feature - Custom Studio RPC handler registration
+ *
+ * Each request type of the `Request.request_type` oneof is served by a handler
+ * registered at compile time with ZMK_TEMPLATE_RPC_HANDLER(). The subsystem
+ * looks the handler up by oneof tag and builds the error response when the
+ * handler fails, so handlers only deal with their own message types.
+ */
+
+#pragma once
+
+#include <string.h>
+
+#include <zephyr/sys/iterable_sections.h>
+#include <zephyr/sys/util.h>
+
+#include <zmk/template/custom.pb.h>
+#include <zmk/template/custom_rpc.h>
+
+/**
+ * Highest `Request.request_type` tag that can be registered. Handlers are
+ * indexed by tag, so this sizes the lookup table. scripts/rpc_codegen.py
+ * reads it from custom.proto, so the table has no unused tail.
+ */
+#define ZMK_TEMPLATE_RPC_MAX_TAG ZMK_TEMPLATE_RPC_REQUEST_MAX_TAG
+
+struct zmk_template_rpc_handler {
+  pb_size_t tag;
+  // Handle a decoded request. Return 0 once `resp` is populated, or a
+  // negative errno to answer with an ErrorResponse.
+  int (*handle)(const zmk_template_Request *req, zmk_template_Response *resp);
+  // Optional. Called with the request message before it is decoded, e.g. to
+  // bind zero-copy views to its bulk fields.
+  void (*prepare)(void *msg);
+  // Run `handle` on the module's work queue instead of the Studio RPC thread
+  bool async;
+  // May be held and run on the module's work queue later when sent with
+  // QOS_BULK, see ZMK_TEMPLATE_RPC_BULK_HANDLER()
+  bool bulk;
+};
+
+/**
+ * Select the `name` member of `resp->response_type` and return a pointer to
+ * it, zeroed. Handlers fill the response buffer through it in place rather
+ * than building the message on the stack and copying it in.
+ */
+#define ZMK_TEMPLATE_RPC_RESPONSE(resp, name)                                  \
+  ((resp)->which_response_type = zmk_template_Response_##name##_tag,           \
+   memset(&(resp)->response_type.name, 0, sizeof((resp)->response_type.name)), \
+   &(resp)->response_type.name)
+
+#define Z_TEMPLATE_RPC_MSG_TYPE(name)                                          \
+  __typeof__(((zmk_template_Request *)0)->request_type.name)
+
+// Encoded Response fields around its response member: the member's tag and
+// length, request_id, compression and state_version
+#define Z_TEMPLATE_RPC_RESPONSE_OVERHEAD 20
+
+#define Z_TEMPLATE_RPC_JOB_RESULT_SIZE                                         \
+  sizeof(((zmk_template_JobResult *)0)->response.bytes)
+
+// Whether held requests run on the async work queue and report their
+// response through a JobResult
+#define Z_TEMPLATE_RPC_HOLDS_REQUESTS                                          \
+  (IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_POWER_SAVE) &&            \
+   IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_ASYNC))
+
+#define Z_TEMPLATE_RPC_HANDLER(name, handler_fn, prepare_ptr, is_async,        \
+                               is_bulk)                                        \
+  BUILD_ASSERT(zmk_template_Request_##name##_tag <= ZMK_TEMPLATE_RPC_MAX_TAG,  \
+               "Request tag exceeds ZMK_TEMPLATE_RPC_MAX_TAG");                \
+  static int z_template_rpc_handle_##name(const zmk_template_Request *req,     \
+                                          zmk_template_Response *resp) {       \
+    zmk_template_rpc_##name##_fn *fn = handler_fn;                             \
+    return fn(&req->request_type.name, resp);                                  \
+  }                                                                            \
+  STRUCT_SECTION_ITERABLE(zmk_template_rpc_handler,                            \
+                          zmk_template_rpc_handler_##name) = {                 \
+      .tag = zmk_template_Request_##name##_tag,                                \
+      .handle = z_template_rpc_handle_##name,                                  \
+      .prepare = prepare_ptr,                                                  \
+      .async = is_async,                                                       \
+      .bulk = is_bulk,                                                         \
+  }
+
+/**
+ * Register `handler_fn` for the `name` member of `Request.request_type`.
+ *
+ * The handler has the generated prototype of the member,
+ * `zmk_template_rpc_<name>_fn`, e.g.
+ * `int fn(const zmk_template_SampleRequest *req, zmk_template_Response *resp)`
+ * for `sample`, so binding a handler to the wrong member is caught by the
+ * compiler as an incompatible pointer type.
+ * Registering the same member twice fails to link.
+ */
+#define ZMK_TEMPLATE_RPC_HANDLER(name, handler_fn)                             \
+  Z_TEMPLATE_RPC_HANDLER(name, handler_fn, NULL, false, false)
+
+/**
+ * Like ZMK_TEMPLATE_RPC_HANDLER(), and additionally call
+ * `void prepare_fn(zmk_template_<Type> *msg)` before the member is decoded.
+ */
+#define ZMK_TEMPLATE_RPC_HANDLER_WITH_PREPARE(name, prepare_fn, handler_fn)    \
+  static void z_template_rpc_prepare_##name(void *msg) {                       \
+    prepare_fn((Z_TEMPLATE_RPC_MSG_TYPE(name) *)msg);                          \
+  }                                                                            \
+  Z_TEMPLATE_RPC_HANDLER(name, handler_fn, z_template_rpc_prepare_##name,      \
+                         false, false)
+
+/**
+ * Like ZMK_TEMPLATE_RPC_HANDLER(), for handlers that may block, e.g. on flash
+ * access. The client is answered at once with a PendingResponse, and
+ * `handler_fn` runs later on the module's work queue with a copy of the
+ * request. Its response is delivered as a JobResult notification and through
+ * GetJobResultRequest.
+ *
+ * The request is copied, so async handlers cannot use zero-copy views into
+ * the request payload. Jobs of requests sent with QOS_BULK are held like
+ * those of ZMK_TEMPLATE_RPC_BULK_HANDLER(). Without
+ * CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_ASYNC the handler runs synchronously
+ * like any other.
+ */
+#define ZMK_TEMPLATE_RPC_ASYNC_HANDLER(name, handler_fn)                       \
+  Z_TEMPLATE_RPC_HANDLER(name, handler_fn, NULL, true, false)
+
+/**
+ * Like ZMK_TEMPLATE_RPC_HANDLER(), for reads that can wait, like stats
+ * syncs. With CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_POWER_SAVE, a request
+ * sent with QOS_BULK while the keyboard is idle on battery is answered with a
+ * PendingResponse, and `handler_fn` runs once bulk traffic is allowed, like
+ * an async handler. Other requests are handled at once.
+ *
+ * `handler_fn` may thus run on the module's work queue with a copy of the
+ * request, alongside handlers on the Studio RPC thread. It must not use
+ * zero-copy views, and must only touch state shared with other handlers or
+ * threads under a lock. Its largest response must fit a JobResult
+ * (CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_JOB_RESULT_MAX_SIZE), which is
+ * checked at build time.
+ */
+#define ZMK_TEMPLATE_RPC_BULK_HANDLER(name, handler_fn)                        \
+  BUILD_ASSERT(!Z_TEMPLATE_RPC_HOLDS_REQUESTS ||                               \
+                   ZMK_TEMPLATE_RPC_RESPONSE_SIZE_##name +                     \
+                           Z_TEMPLATE_RPC_RESPONSE_OVERHEAD <=                 \
+                       Z_TEMPLATE_RPC_JOB_RESULT_SIZE,                         \
+               "Held " #name " responses do not fit a JobResult, raise "      \
+               "CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_JOB_RESULT_MAX_SIZE"); \
+  Z_TEMPLATE_RPC_HANDLER(name, handler_fn, NULL, false, true)
@@ -0,0 +1,43 @@
+/**
+ * Template Feature - Streamed response fields
+ *
+ * Helpers to encode a repeated message field element by element straight into
+ * the nanopb output stream instead of materializing it in the response buffer.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <pb.h>
+
+/**
+ * Fill `item` with the element at `index`. `item` is zeroed before the call.
+ * Return false to end the stream early.
+ *
+ * nanopb calls encode callbacks more than once (sizing pass, then writing
+ * pass), so this must produce the same elements every time it is called.
+ */
+typedef bool (*zmk_template_rpc_stream_next_fn)(size_t index, void *item,
+                                                void *user_data);
+
+struct zmk_template_rpc_stream {
+  // Descriptor and scratch storage for a single element
+  const pb_msgdesc_t *item_fields;
+  void *item;
+  size_t item_size;
+
+  // Upper bound of elements to emit
+  size_t count;
+  zmk_template_rpc_stream_next_fn next;
+  void *user_data;
+};
+
+/**
+ * Bind `stream` to a repeated FT_CALLBACK field of a response.
+ * `stream` must stay valid until the response has been encoded, i.e. after
+ * the custom RPC handler returned; use static storage.
+ */
+void zmk_template_rpc_stream_attach(pb_callback_t *field,
+                                    struct zmk_template_rpc_stream *stream);
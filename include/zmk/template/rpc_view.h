@@ -0,0 +1,46 @@
+/**
+ * Template Feature - Zero-copy request fields
+ *
+ * Exposes bytes/string fields of a decoded request as pointer+length views
+ * into the raw request payload instead of copying them into fixed arrays.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pb.h>
+
+struct zmk_template_rpc_view {
+  const uint8_t *data;
+  size_t size;
+};
+
+/**
+ * Storage for the views of one FT_CALLBACK field.
+ * For a singular field use capacity 1; a repeated occurrence overwrites it as
+ * protobuf's "last one wins" rule requires. A repeated field with more
+ * entries than `capacity` fails the decode.
+ */
+struct zmk_template_rpc_views {
+  struct zmk_template_rpc_view *items;
+  size_t capacity;
+  size_t count;
+};
+
+/**
+ * Bind `views` to a bytes/string FT_CALLBACK field before it is decoded.
+ * The views point into the decoded buffer, so they are only valid while that
+ * buffer is, i.e. within the custom RPC handler call.
+ */
+void zmk_template_rpc_views_attach(pb_callback_t *field,
+                                   struct zmk_template_rpc_views *views);
+
+/**
+ * Views bound to `field` by zmk_template_rpc_views_attach().
+ */
+static inline const struct zmk_template_rpc_views *
+zmk_template_rpc_views_get(const pb_callback_t *field) {
+  return field->arg;
+}
@@ -0,0 +1,53 @@
+/**
+ * Template Feature - Module state
+ *
+ * Versioned state shared with the web UI. Every change bumps a version
+ * number, and the web UI fetches only the fields changed since the version
+ * it already holds (GetStateSinceRequest).
+ */
+
+#pragma once
+
+#include <errno.h>
+#include <stdint.h>
+
+#include <zephyr/sys/util.h>
+
+#include <zmk/template/custom.pb.h>
+
+#if IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_STATE)
+
+/**
+ * Copy the current state into `out` with every field set.
+ */
+void zmk_template_state_get(zmk_template_ModuleState *out);
+
+/**
+ * Apply the fields set in `changes`. Fields set to their current value keep
+ * their version, so they are not resent. The web UI is notified when
+ * anything changed. Safe to call from any thread.
+ *
+ * @retval 0 on success
+ * @retval -EINVAL if a value is out of range; nothing is applied
+ */
+int zmk_template_state_update(const zmk_template_ModuleState *changes);
+
+/**
+ * Current state version. It grows with every change until the next boot.
+ */
+uint32_t zmk_template_state_version(void);
+
+#else
+
+static inline void zmk_template_state_get(zmk_template_ModuleState *out) {
+  *out = (zmk_template_ModuleState)zmk_template_ModuleState_init_zero;
+}
+
+static inline int
+zmk_template_state_update(const zmk_template_ModuleState *changes) {
+  return -ENOTSUP;
+}
+
+static inline uint32_t zmk_template_state_version(void) { return 0; }
+
+#endif
@@ -0,0 +1,85 @@
+"""Print the size of every generated template message and check RAM budgets.
+
+Reads the footprint object built by CMakeLists.txt, where each message
+`zmk_template_<Name>` is mirrored by an array `template_sizeof_<Name>` of
+the same size, and exits non-zero when a budgeted message outgrows it.
+"""
+
+import argparse
+import subprocess
+import sys
+
+SYMBOL_PREFIX = "template_sizeof_"
+
+
+def read_sizes(nm: str, objects: list[str]) -> dict[str, int]:
+    sizes: dict[str, int] = {}
+    for obj in objects:
+        output = subprocess.run(
+            [nm, "--print-size", "--radix=d", obj],
+            capture_output=True,
+            text=True,
+            check=True,
+        ).stdout
+        for line in output.splitlines():
+            fields = line.split()
+            # <address> <size> <type> <name>
+            if len(fields) == 4 and fields[3].startswith(SYMBOL_PREFIX):
+                sizes[fields[3][len(SYMBOL_PREFIX):]] = int(fields[1])
+    return sizes
+
+
+def parse_budget(value: str) -> tuple[str, int]:
+    name, _, limit = value.partition("=")
+    if not name or not limit.isdigit():
+        raise argparse.ArgumentTypeError(f"expected <Message>=<bytes>: {value}")
+    return name, int(limit)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--nm", required=True, help="nm of the toolchain")
+    parser.add_argument(
+        "--budget",
+        type=parse_budget,
+        action="append",
+        default=[],
+        help="<Message>=<bytes>, may be repeated",
+    )
+    parser.add_argument("objects", nargs="+")
+    args = parser.parse_args()
+
+    sizes = read_sizes(args.nm, args.objects)
+    if not sizes:
+        print("footprint: no message sizes found", file=sys.stderr)
+        return 1
+
+    budgets = dict(args.budget)
+    width = max(len(name) for name in sizes)
+    over = []
+    for name, size in sorted(sizes.items(), key=lambda item: -item[1]):
+        line = f"  {name:<{width}} {size:>6} B"
+        if name in budgets:
+            line += f"  (budget {budgets[name]} B)"
+            if size > budgets[name]:
+                over.append(name)
+                line += "  OVER BUDGET"
+        print(line)
+
+    for name in budgets:
+        if name not in sizes:
+            print(f"footprint: unknown message {name}", file=sys.stderr)
+            return 1
+
+    if over:
+        print(
+            "footprint: over budget: " + ", ".join(over) + ". Lower the "
+            "limits under \"Message size limits\" or raise the budget.",
+            file=sys.stderr,
+        )
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,146 @@
+"""Write the log dictionary the web UI uses to format captured log records.
+
+Captured records (CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_LOG_CAPTURE) refer
+to format strings and constant string arguments by address, and to their log
+module by source ID. This reads both tables from the firmware ELF:
+
+- `strings`: every NUL-terminated string in allocated, read-only data
+  sections, keyed by address
+- `sources`: log module names, keyed by the index of their
+  `log_const_<name>` entry in the `log_const` area
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+SHT_PROGBITS = 1
+SHT_SYMTAB = 2
+SHF_WRITE = 0x1
+SHF_ALLOC = 0x2
+SHF_EXECINSTR = 0x4
+
+SOURCE_PREFIX = "log_const_"
+SOURCE_AREA_START = "__log_const_start"
+
+# Shortest run of printable bytes kept as a string
+MIN_STRING_LENGTH = 2
+PRINTABLE = set(range(0x20, 0x7F)) | {ord("\t"), ord("\n")}
+
+
+class Elf:
+    def __init__(self, data: bytes):
+        if data[:4] != b"\x7fELF":
+            raise ValueError("not an ELF file")
+        self.data = data
+        self.is64 = data[4] == 2
+        self.endian = "<" if data[5] == 1 else ">"
+
+        if self.is64:
+            shoff, = self.unpack("Q", 0x28)
+            shentsize, shnum, shstrndx = self.unpack("HHH", 0x3A)
+        else:
+            shoff, = self.unpack("I", 0x20)
+            shentsize, shnum, shstrndx = self.unpack("HHH", 0x2E)
+
+        self.sections = [
+            self.read_section(shoff + i * shentsize) for i in range(shnum)
+        ]
+        names = self.sections[shstrndx]
+        for section in self.sections:
+            section["name"] = self.cstring(names["offset"] + section["name"])
+
+    def unpack(self, fmt: str, offset: int) -> tuple:
+        return struct.unpack_from(self.endian + fmt, self.data, offset)
+
+    def cstring(self, offset: int) -> str:
+        end = self.data.index(b"\0", offset)
+        return self.data[offset:end].decode(errors="replace")
+
+    def read_section(self, offset: int) -> dict:
+        if self.is64:
+            fields = self.unpack("IIQQQQIIQQ", offset)
+        else:
+            fields = self.unpack("IIIIIIIIII", offset)
+        keys = ("name", "type", "flags", "addr", "offset", "size", "link")
+        return dict(zip(keys, fields))
+
+    def symbols(self):
+        for section in self.sections:
+            if section["type"] != SHT_SYMTAB:
+                continue
+            strtab = self.sections[section["link"]]
+            entsize = 24 if self.is64 else 16
+            for offset in range(
+                section["offset"], section["offset"] + section["size"], entsize
+            ):
+                if self.is64:
+                    name, _, _, _, value, size = self.unpack("IBBHQQ", offset)
+                else:
+                    name, value, size = self.unpack("III", offset)
+                yield self.cstring(strtab["offset"] + name), value, size
+
+
+def read_strings(elf: Elf) -> dict[int, str]:
+    strings: dict[int, str] = {}
+    for section in elf.sections:
+        flags = section["flags"]
+        if (
+            section["type"] != SHT_PROGBITS
+            or not flags & SHF_ALLOC
+            or flags & (SHF_WRITE | SHF_EXECINSTR)
+        ):
+            continue
+
+        data = elf.data[section["offset"] : section["offset"] + section["size"]]
+        start = 0
+        for i, byte in enumerate(data):
+            if byte in PRINTABLE:
+                continue
+            if byte == 0 and i - start >= MIN_STRING_LENGTH:
+                text = data[start:i].decode("ascii")
+                strings[section["addr"] + start] = text
+            start = i + 1
+    return strings
+
+
+def read_sources(elf: Elf) -> dict[int, str]:
+    area_start = None
+    entries: list[tuple[int, int, str]] = []
+    for name, value, size in elf.symbols():
+        if name == SOURCE_AREA_START:
+            area_start = value
+        elif name.startswith(SOURCE_PREFIX) and size:
+            entries.append((value, size, name[len(SOURCE_PREFIX) :]))
+
+    if area_start is None:
+        return {}
+    return {
+        (value - area_start) // size: name for value, size, name in entries
+    }
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("elf", help="firmware image, e.g. zephyr/zephyr.elf")
+    parser.add_argument("output", help="dictionary JSON to write")
+    args = parser.parse_args()
+
+    with open(args.elf, "rb") as f:
+        elf = Elf(f.read())
+
+    dictionary = {"strings": read_strings(elf), "sources": read_sources(elf)}
+    with open(args.output, "w") as f:
+        json.dump(dictionary, f)
+
+    print(
+        f"{len(dictionary['strings'])} strings, "
+        f"{len(dictionary['sources'])} log sources",
+        file=sys.stderr,
+    )
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
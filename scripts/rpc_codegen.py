@@ -0,0 +1,319 @@
+"""Generate the typed RPC method bindings of custom.proto.
+
+The request and response types are paired from the `Request.request_type`
+and `Response.response_type` oneofs. A request is answered by the response
+member of the same name, or of its name without a `get_` prefix, unless its
+line in the oneof says otherwise with a `// response: <member>` comment.
+
+- `--c HEADER`: handler prototypes, response sizes and the request tag
+  range for the firmware, written by CMake next to the nanopb output
+- protoc plugin (no arguments): TypeScript method types and bindings for the
+  web UI, run by `buf generate`. The `proto_path` option names the directory
+  the proto files are read from.
+
+A method whose response has a `bool more` field is streamed: it is repeated
+until a response arrives without `more`. BatchRequest entries can carry any
+other request, so `batch` itself gets no binding.
+"""
+
+import argparse
+import os
+import re
+import sys
+from dataclasses import dataclass
+
+REQUEST_ONEOF = ("Request", "request_type")
+RESPONSE_ONEOF = ("Response", "response_type")
+BATCH_REQUEST = "BatchRequest"
+FEATURE_PROTO3_OPTIONAL = 1
+STREAM_FIELD = re.compile(r"^\s*bool\s+more\s*=", re.MULTILINE)
+
+# Message bodies may hold one level of braces, i.e. a oneof
+MESSAGE = re.compile(
+    r"^message\s+(\w+)\s*\{((?:[^{}]|\{[^{}]*\})*)\}", re.MULTILINE
+)
+MEMBER = re.compile(
+    r"^\s*(\w+)\s+(\w+)\s*=\s*(\d+)\s*;[ \t]*(?://\s*response:\s*(\w+))?",
+    re.MULTILINE,
+)
+
+HEADER_NOTE = "Generated by scripts/rpc_codegen.py from {}. Do not edit."
+
+
+@dataclass
+class Method:
+    name: str
+    tag: int
+    request_type: str
+    response_member: str
+    response_type: str
+    streamed: bool
+
+    # ts-proto names fields in lowerCamelCase
+    @property
+    def ts_name(self) -> str:
+        return camel_case(self.name)
+
+    @property
+    def ts_response_member(self) -> str:
+        return camel_case(self.response_member)
+
+
+def camel_case(name: str) -> str:
+    head, *rest = name.split("_")
+    return head + "".join(word.capitalize() for word in rest)
+
+
+def oneof_members(messages: dict[str, str], message: str, oneof: str):
+    body = messages.get(message)
+    match = body and re.search(
+        r"oneof\s+" + oneof + r"\s*\{(.*?)\}", body, re.DOTALL
+    )
+    if not match:
+        raise ValueError(f"{message}.{oneof} not found")
+    return MEMBER.findall(match.group(1))
+
+
+def parse(source: str) -> list[Method]:
+    messages = dict(MESSAGE.findall(source))
+    responses = {
+        name: type_name
+        for type_name, name, _, _ in oneof_members(messages, *RESPONSE_ONEOF)
+    }
+
+    methods = []
+    for type_name, name, tag, response in oneof_members(
+        messages, *REQUEST_ONEOF
+    ):
+        if not response:
+            response = name if name in responses else name.removeprefix("get_")
+        if response not in responses:
+            raise ValueError(
+                f"no response member for request {name}, "
+                "add a `// response: <member>` comment"
+            )
+        response_type = responses[response]
+        methods.append(
+            Method(
+                name=name,
+                tag=int(tag),
+                request_type=type_name,
+                response_member=response,
+                response_type=response_type,
+                streamed=bool(
+                    STREAM_FIELD.search(messages.get(response_type, ""))
+                ),
+            )
+        )
+    return methods
+
+
+def generate_c(methods: list[Method], proto: str) -> str:
+    lines = [
+        "/**",
+        f" * {HEADER_NOTE.format(proto)}",
+        " */",
+        "",
+        "#pragma once",
+        "",
+        "#include <zmk/template/custom.pb.h>",
+        "",
+        "// Highest `Request.request_type` tag",
+        "#define ZMK_TEMPLATE_RPC_REQUEST_MAX_TAG "
+        f"{max(method.tag for method in methods)}",
+        "",
+        "// Handler prototype of each `Request.request_type` member",
+    ]
+    for method in methods:
+        lines += [
+            f"typedef int zmk_template_rpc_{method.name}_fn(",
+            f"    const zmk_template_{method.request_type} *req,",
+            "    zmk_template_Response *resp);",
+        ]
+    lines += [
+        "",
+        "// Largest encoded response of each `Request.request_type` member. Only",
+        "// defined by nanopb for responses of bounded size.",
+    ]
+    for method in methods:
+        lines.append(
+            f"#define ZMK_TEMPLATE_RPC_RESPONSE_SIZE_{method.name} "
+            f"zmk_template_{method.response_type}_size"
+        )
+    return "\n".join(lines) + "\n"
+
+
+def generate_ts(methods: list[Method], proto: str) -> str:
+    bound = [m for m in methods if m.request_type != BATCH_REQUEST]
+    streamed = [m for m in bound if m.streamed]
+    types = sorted(
+        {method.request_type for method in methods}
+        | {method.response_type for method in methods}
+    )
+
+    lines = [f"// {HEADER_NOTE.format(proto)}", ""]
+    lines.append("import type {")
+    lines += [f"  {name}," for name in ["DeepPartial", "Response", *types]]
+    lines += ['} from "./custom";', ""]
+
+    lines.append("// Request and response message of each Request member")
+    lines.append("export interface TemplateMethods {")
+    for method in methods:
+        lines.append(
+            f"  {method.ts_name}: {{ request: {method.request_type}; "
+            f"response: {method.response_type} }};"
+        )
+    lines += [
+        "}",
+        "",
+        "export type TemplateMethod = keyof TemplateMethods;",
+        "",
+        "// Methods whose response sets `more` while further pages remain",
+        "export type TemplateStreamMethod ="
+        + "".join(f'\n  | "{method.ts_name}"' for method in streamed)
+        + (";" if streamed else " never;"),
+        "",
+        "// Response member answering each Request member",
+        "export const RESPONSE_MEMBERS = {",
+    ]
+    for method in methods:
+        lines.append(f'  {method.ts_name}: "{method.ts_response_member}",')
+    lines += [
+        "} as const satisfies Record<TemplateMethod, keyof Response>;",
+        "",
+        "// Names of the Request.request_type members, keyed by oneof tag",
+        "export const REQUEST_TYPE_NAMES: Record<number, TemplateMethod> = {",
+    ]
+    for method in methods:
+        lines.append(f'  {method.tag}: "{method.ts_name}",')
+    lines += [
+        "};",
+        "",
+        "// Sends one Request member and resolves with its response member",
+        "export type InvokeFn = <M extends TemplateMethod>(",
+        "  method: M,",
+        '  request: DeepPartial<TemplateMethods[M]["request"]>',
+        ') => Promise<TemplateMethods[M]["response"]>;',
+        "",
+        "// One function per request type, batches are built from entries",
+        "export interface TemplateMethodFns {",
+    ]
+    for method in bound:
+        lines.append(
+            f"  {method.ts_name}(request: DeepPartial<{method.request_type}>): "
+            f"Promise<{method.response_type}>;"
+        )
+    lines += [
+        "}",
+        "",
+        "export function bindTemplateMethods(",
+        "  invoke: InvokeFn",
+        "): TemplateMethodFns {",
+        "  return {",
+    ]
+    for method in bound:
+        lines.append(
+            f'    {method.ts_name}: (request) => invoke("{method.ts_name}", '
+            "request),"
+        )
+    lines += ["  };", "}"]
+    return "\n".join(lines) + "\n"
+
+
+# protoc plugin protocol, only the fields used here
+
+def read_varint(data: bytes, offset: int) -> tuple[int, int]:
+    value = shift = 0
+    while True:
+        byte = data[offset]
+        offset += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, offset
+
+
+def read_fields(data: bytes):
+    offset = 0
+    while offset < len(data):
+        key, offset = read_varint(data, offset)
+        number, wire_type = key >> 3, key & 7
+        if wire_type == 0:
+            value, offset = read_varint(data, offset)
+        elif wire_type == 1:
+            value, offset = data[offset : offset + 8], offset + 8
+        elif wire_type == 2:
+            size, offset = read_varint(data, offset)
+            value, offset = data[offset : offset + size], offset + size
+        elif wire_type == 5:
+            value, offset = data[offset : offset + 4], offset + 4
+        else:
+            raise ValueError(f"unsupported wire type {wire_type}")
+        yield number, value
+
+
+def write_varint(value: int) -> bytes:
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        out.append(byte | (0x80 if value else 0))
+        if not value:
+            return bytes(out)
+
+
+def write_bytes(number: int, value: bytes) -> bytes:
+    return write_varint(number << 3 | 2) + write_varint(len(value)) + value
+
+
+def run_plugin() -> int:
+    files, parameter = [], ""
+    for number, value in read_fields(sys.stdin.buffer.read()):
+        if number == 1:
+            files.append(value.decode())
+        elif number == 2:
+            parameter = value.decode()
+    options = dict(
+        option.split("=", 1) for option in parameter.split(",") if "=" in option
+    )
+    proto_path = options.get("proto_path", ".")
+
+    # proto3 `optional` fields need no handling here
+    response = write_varint(2 << 3) + write_varint(FEATURE_PROTO3_OPTIONAL)
+    for name in files:
+        with open(os.path.join(proto_path, name)) as f:
+            source = f.read()
+        if not re.search(r"^message\s+Request\b", source, re.MULTILINE):
+            continue
+        try:
+            content = generate_ts(parse(source), name)
+        except ValueError as e:
+            response += write_bytes(1, f"{name}: {e}".encode())
+            break
+        output = os.path.splitext(name)[0] + "_rpc.ts"
+        generated = write_bytes(1, output.encode())
+        generated += write_bytes(15, content.encode())
+        response += write_bytes(15, generated)
+    sys.stdout.buffer.write(response)
+    return 0
+
+
+def main() -> int:
+    if len(sys.argv) == 1:
+        return run_plugin()
+
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--c", required=True, metavar="HEADER")
+    parser.add_argument("proto", help="e.g. proto/zmk/template/custom.proto")
+    args = parser.parse_args()
+
+    with open(args.proto) as f:
+        methods = parse(f.read())
+    os.makedirs(os.path.dirname(args.c) or ".", exist_ok=True)
+    with open(args.c, "w") as f:
+        f.write(generate_c(methods, os.path.basename(args.proto)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,277 @@
+/**
+ * Template Feature - Async request handling
+ *
+ * Handlers registered with ZMK_TEMPLATE_RPC_ASYNC_HANDLER() run on a work
+ * queue owned by this module, so a slow handler does not hold up the Studio
+ * RPC thread and with it every other subsystem. Each submitted request takes
+ * a job slot until its result is fetched with GetJobResultRequest, or until
+ * the slot is needed for a new job once the result has been sent in a
+ * JobResult notification. Results that could not be sent stay until fetched.
+ *
+ * Bulk requests for bulk and async handlers also come through here while the
+ * keyboard is idle on battery. Their jobs are held until
+ * template_rpc_async_release_held().
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <pb_encode.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include <zmk/template/lazy_init.h>
+#include <zmk/template/notification.h>
+#include <zmk/template/rpc.h>
+
+#include "async.h"
+#include "compress.h"
+#include "error.h"
+#include "power.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#define MAX_JOBS CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_ASYNC_MAX_JOBS
+
+enum job_state {
+  JOB_FREE,
+  // Waiting for bulk traffic to be allowed
+  JOB_HELD,
+  JOB_QUEUED,
+  JOB_RUNNING,
+  JOB_DONE,
+};
+
+struct job {
+  struct k_work work;
+  enum job_state state;
+  const struct zmk_template_rpc_handler *handler;
+  zmk_template_Request request;
+  // job_id is set on submit, done and response once the handler finished
+  zmk_template_JobResult result;
+  // The result was queued as a notification, so the slot may be reused
+  bool delivered;
+};
+
+static struct job jobs[MAX_JOBS];
+static uint32_t last_job_id;
+static struct k_spinlock lock;
+
+// Whether `a` was submitted before `b`. Job IDs wrap, so their distance is
+// compared rather than their values.
+static bool submitted_before(const struct job *a, const struct job *b) {
+  return (int32_t)(a->result.job_id - b->result.job_id) < 0;
+}
+
+K_THREAD_STACK_DEFINE(async_stack,
+                      CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_ASYNC_STACK_SIZE);
+static struct k_work_q async_queue;
+
+// Jobs run one at a time on `async_queue`, so they share this buffer
+static zmk_template_Response job_response;
+
+static bool encode_job_response(zmk_template_JobResult *result) {
+  pb_ostream_t stream = pb_ostream_from_buffer(result->response.bytes,
+                                               sizeof(result->response.bytes));
+  if (!pb_encode(&stream, zmk_template_Response_fields, &job_response)) {
+    LOG_WRN("Failed to encode job %d response: %s", result->job_id,
+            PB_GET_ERROR(&stream));
+    return false;
+  }
+  result->response.size = stream.bytes_written;
+  return true;
+}
+
+static void run_job(struct k_work *work) {
+  struct job *job = CONTAINER_OF(work, struct job, work);
+
+  k_spinlock_key_t key = k_spin_lock(&lock);
+  job->state = JOB_RUNNING;
+  k_spin_unlock(&lock, key);
+
+  memset(&job_response, 0, sizeof(job_response));
+  int rc = job->handler->handle(&job->request, &job_response);
+  if (rc == 0) {
+    template_rpc_compress_response(&job->request, &job_response);
+  } else {
+    template_rpc_set_handler_error(&job_response, rc);
+  }
+  job_response.request_id = job->request.request_id;
+
+  zmk_template_Notification notification = {
+      .which_notification_type = zmk_template_Notification_job_result_tag,
+      .qos = job->request.qos,
+  };
+  zmk_template_JobResult *result = &notification.notification_type.job_result;
+  result->job_id = job->result.job_id;
+  result->done = true;
+  if (!encode_job_response(result)) {
+    memset(&job_response, 0, sizeof(job_response));
+    template_rpc_set_error(&job_response,
+                           zmk_template_ErrorCode_ERROR_CODE_RESPONSE_TOO_LARGE,
+                           0, "Response too large for async job");
+    job_response.request_id = job->request.request_id;
+    encode_job_response(result);
+  }
+
+  key = k_spin_lock(&lock);
+  job->result = *result;
+  job->state = JOB_DONE;
+  job->delivered = false;
+  k_spin_unlock(&lock, key);
+
+  LOG_DBG("Job %d done", result->job_id);
+  // Held notifications may still be dropped, so they do not count as sent
+  const bool held = notification.qos == zmk_template_Qos_QOS_BULK &&
+                    !template_power_bulk_allowed();
+  // Clients that miss this poll with GetJobResultRequest instead
+  rc = zmk_template_notify_no_coalesce(&notification);
+  if (rc == -EMSGSIZE) {
+    // Only the job's response fits a call response, so the client fetches it
+    result->response.size = 0;
+    zmk_template_notify_no_coalesce(&notification);
+  }
+  if (rc != 0 || held) {
+    LOG_DBG("Job %d result kept until fetched", result->job_id);
+    return;
+  }
+
+  key = k_spin_lock(&lock);
+  // Unless fetched, and the slot reused by a new job, meanwhile
+  if (job->state == JOB_DONE && job->result.job_id == result->job_id) {
+    job->delivered = true;
+  }
+  k_spin_unlock(&lock, key);
+}
+
+static int template_rpc_async_init(void) {
+  const struct k_work_queue_config config = {.name = "template_rpc_async"};
+
+  k_work_queue_init(&async_queue);
+  k_work_queue_start(&async_queue, async_stack,
+                     K_THREAD_STACK_SIZEOF(async_stack),
+                     CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_ASYNC_PRIORITY,
+                     &config);
+  return 0;
+}
+
+// The queue's thread is only started once the web UI is in use
+ZMK_TEMPLATE_LAZY_INIT(async_queue, template_rpc_async_init);
+
+/**
+ * Pick a slot: a free one, else the one holding the oldest delivered result.
+ * Results that were not delivered are never evicted, since the client can
+ * only get them with GetJobResultRequest. Called with `lock` held.
+ */
+static struct job *claim_job(void) {
+  struct job *oldest_delivered = NULL;
+
+  for (int i = 0; i < MAX_JOBS; i++) {
+    if (jobs[i].state == JOB_FREE) {
+      return &jobs[i];
+    }
+    if (jobs[i].state == JOB_DONE && jobs[i].delivered &&
+        (!oldest_delivered || submitted_before(&jobs[i], oldest_delivered))) {
+      oldest_delivered = &jobs[i];
+    }
+  }
+  return oldest_delivered;
+}
+
+int template_rpc_async_submit(const struct zmk_template_rpc_handler *handler,
+                              const zmk_template_Request *req,
+                              zmk_template_Response *resp, bool hold) {
+  int rc = ZMK_TEMPLATE_LAZY_INIT_ENSURE(async_queue);
+  if (rc != 0) {
+    return rc;
+  }
+
+  k_spinlock_key_t key = k_spin_lock(&lock);
+
+  struct job *job = claim_job();
+  if (!job) {
+    k_spin_unlock(&lock, key);
+    LOG_WRN("No free async job slot");
+    return -EBUSY;
+  }
+
+  if (++last_job_id == 0) {
+    last_job_id = 1;
+  }
+  job->state = hold ? JOB_HELD : JOB_QUEUED;
+  job->delivered = false;
+  job->handler = handler;
+  job->request = *req;
+  job->result = (zmk_template_JobResult){.job_id = last_job_id};
+  const uint32_t job_id = last_job_id;
+  k_work_init(&job->work, run_job);
+
+  k_spin_unlock(&lock, key);
+
+  if (!hold) {
+    k_work_submit_to_queue(&async_queue, &job->work);
+  } else if (template_power_bulk_allowed()) {
+    // Allowed again since the caller checked, and nothing else would
+    // release the job until the next change
+    template_rpc_async_release_held();
+  } else {
+    LOG_DBG("Holding bulk job %d", job_id);
+  }
+
+  ZMK_TEMPLATE_RPC_RESPONSE(resp, pending)->job_id = job_id;
+  return 0;
+}
+
+void template_rpc_async_release_held(void) {
+  struct job *released[MAX_JOBS];
+  size_t count = 0;
+
+  k_spinlock_key_t key = k_spin_lock(&lock);
+  // Slots are claimed in no particular order, so queue by job id
+  for (;;) {
+    struct job *oldest = NULL;
+    for (int i = 0; i < MAX_JOBS; i++) {
+      if (jobs[i].state == JOB_HELD &&
+          (!oldest || submitted_before(&jobs[i], oldest))) {
+        oldest = &jobs[i];
+      }
+    }
+    if (!oldest) {
+      break;
+    }
+    oldest->state = JOB_QUEUED;
+    released[count++] = oldest;
+  }
+  k_spin_unlock(&lock, key);
+
+  for (size_t i = 0; i < count; i++) {
+    k_work_submit_to_queue(&async_queue, &released[i]->work);
+  }
+}
+
+static int handle_get_job_result(const zmk_template_GetJobResultRequest *req,
+                                 zmk_template_Response *resp) {
+  int rc = -ENOENT;
+  k_spinlock_key_t key = k_spin_lock(&lock);
+
+  for (int i = 0; i < MAX_JOBS; i++) {
+    struct job *job = &jobs[i];
+    if (job->state == JOB_FREE || job->result.job_id != req->job_id) {
+      continue;
+    }
+
+    resp->which_response_type = zmk_template_Response_job_result_tag;
+    resp->response_type.job_result = job->result;
+    if (job->state == JOB_DONE) {
+      job->state = JOB_FREE;
+    }
+    rc = 0;
+    break;
+  }
+
+  k_spin_unlock(&lock, key);
+  return rc;
+}
+
+ZMK_TEMPLATE_RPC_HANDLER(get_job_result, handle_get_job_result);
@@ -0,0 +1,46 @@
+/**
+ * Template Feature - Async request handling (internal)
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include <zephyr/sys/util.h>
+
+#include <zmk/template/custom.pb.h>
+#include <zmk/template/rpc.h>
+
+#if IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_ASYNC)
+
+/**
+ * Queue `req` for `handler` on the async work queue and answer with a
+ * PendingResponse. With `hold`, the job waits for
+ * template_rpc_async_release_held() unless bulk traffic is allowed by then.
+ *
+ * @retval 0 with `resp` populated
+ * @retval -EBUSY if every job slot holds a job, or a result that was not
+ *         delivered and not fetched yet
+ */
+int template_rpc_async_submit(const struct zmk_template_rpc_handler *handler,
+                              const zmk_template_Request *req,
+                              zmk_template_Response *resp, bool hold);
+
+/**
+ * Queue the held jobs, oldest first.
+ */
+void template_rpc_async_release_held(void);
+
+#else
+
+// Without a work queue to defer them to, held requests run at once
+static inline int
+template_rpc_async_submit(const struct zmk_template_rpc_handler *handler,
+                          const zmk_template_Request *req,
+                          zmk_template_Response *resp, bool hold) {
+  return handler->handle(req, resp);
+}
+
+static inline void template_rpc_async_release_held(void) {}
+
+#endif
@@ -0,0 +1,134 @@
+/**
+ * Template Feature - Response compression
+ *
+ * Key usage tables, scratch blobs and log records are mostly zeros and
+ * repeated bytes, so a byte-oriented run-length code already shrinks them
+ * severalfold, without the history window an LZ-style coder would need.
+ * Output is built in a fixed scratch buffer of
+ * CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_COMPRESSION_SCRATCH_SIZE bytes and
+ * only replaces the field when it is shorter.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include "compress.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+// Shorter runs cost more as a run than as part of a literal
+#define RLE_MIN_RUN 3
+#define RLE_MAX_RUN (0x7f + RLE_MIN_RUN)
+#define RLE_MAX_LITERAL 0x80
+#define RLE_RUN_FLAG 0x80
+
+// One buffer serves every response. Async jobs are compressed on their work
+// queue while the RPC thread handles other requests, so it is locked.
+static uint8_t
+    scratch[CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_COMPRESSION_SCRATCH_SIZE];
+static K_MUTEX_DEFINE(scratch_lock);
+
+struct rle_out {
+  uint8_t *buf;
+  size_t size;
+  size_t len;
+};
+
+static bool put_literals(struct rle_out *out, const uint8_t *data, size_t n) {
+  while (n > 0) {
+    size_t chunk = MIN(n, RLE_MAX_LITERAL);
+    if (out->len + 1 + chunk > out->size) {
+      return false;
+    }
+    out->buf[out->len++] = chunk - 1;
+    memcpy(&out->buf[out->len], data, chunk);
+    out->len += chunk;
+    data += chunk;
+    n -= chunk;
+  }
+  return true;
+}
+
+static bool put_run(struct rle_out *out, uint8_t value, size_t run) {
+  if (out->len + 2 > out->size) {
+    return false;
+  }
+  out->buf[out->len++] = RLE_RUN_FLAG | (run - RLE_MIN_RUN);
+  out->buf[out->len++] = value;
+  return true;
+}
+
+int template_rle_encode(const uint8_t *in, size_t len, uint8_t *out,
+                        size_t size) {
+  struct rle_out rle = {.buf = out, .size = size};
+  // Start of the bytes not encoded yet, sent as literals before the next run
+  size_t literal = 0;
+  size_t i = 0;
+
+  while (i < len) {
+    size_t run = 1;
+    while (i + run < len && run < RLE_MAX_RUN && in[i + run] == in[i]) {
+      run++;
+    }
+    if (run < RLE_MIN_RUN) {
+      i += run;
+      continue;
+    }
+    if (!put_literals(&rle, &in[literal], i - literal) ||
+        !put_run(&rle, in[i], run)) {
+      return -ENOSPC;
+    }
+    i += run;
+    literal = i;
+  }
+  if (!put_literals(&rle, &in[literal], len - literal)) {
+    return -ENOSPC;
+  }
+  return rle.len;
+}
+
+void template_rpc_compress_response(const zmk_template_Request *req,
+                                    zmk_template_Response *resp) {
+  if (req->accept_compression != zmk_template_Compression_COMPRESSION_RLE) {
+    return;
+  }
+
+  uint8_t *bytes;
+  pb_size_t *size;
+  switch (resp->which_response_type) {
+  case zmk_template_Response_usage_stats_tag:
+    bytes = resp->response_type.usage_stats.counts.bytes;
+    size = &resp->response_type.usage_stats.counts.size;
+    break;
+  case zmk_template_Response_read_chunk_tag:
+    bytes = resp->response_type.read_chunk.data.bytes;
+    size = &resp->response_type.read_chunk.data.size;
+    break;
+  case zmk_template_Response_read_logs_tag:
+    bytes = resp->response_type.read_logs.records.bytes;
+    size = &resp->response_type.read_logs.records.size;
+    break;
+  default:
+    return;
+  }
+  if (*size == 0) {
+    return;
+  }
+
+  k_mutex_lock(&scratch_lock, K_FOREVER);
+  // Limiting the output to one byte less than the input keeps only savings
+  int len = template_rle_encode(bytes, *size, scratch,
+                                MIN(sizeof(scratch), (size_t)*size - 1));
+  if (len >= 0) {
+    LOG_DBG("Compressed response %d from %d to %d bytes",
+            resp->which_response_type, *size, len);
+    memcpy(bytes, scratch, len);
+    *size = len;
+    resp->compression = zmk_template_Compression_COMPRESSION_RLE;
+  }
+  k_mutex_unlock(&scratch_lock);
+}
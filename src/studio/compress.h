@@ -0,0 +1,40 @@
+/**
+ * Template Feature - Response compression (internal)
+ *
+ * Run-length encodes the bulk bytes field of a response in place for clients
+ * that accept it. Compiles to nothing unless
+ * CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_COMPRESSION is enabled.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zephyr/sys/util.h>
+
+#include <zmk/template/custom.pb.h>
+
+#if IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_COMPRESSION)
+
+/**
+ * Encode `len` bytes of `in` as COMPRESSION_RLE into `out` of `size` bytes.
+ * Returns the encoded length, or -ENOSPC if it does not fit.
+ */
+int template_rle_encode(const uint8_t *in, size_t len, uint8_t *out,
+                        size_t size);
+
+/**
+ * Compress the bulk field of the successful response `resp` to `req` if the
+ * request accepts it and the result is smaller.
+ */
+void template_rpc_compress_response(const zmk_template_Request *req,
+                                    zmk_template_Response *resp);
+
+#else
+
+static inline void
+template_rpc_compress_response(const zmk_template_Request *req,
+                               zmk_template_Response *resp) {}
+
+#endif
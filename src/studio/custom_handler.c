@@ -5,10 +5,29 @@
  * It demonstrates the minimum code needed to handle custom RPC requests.
  */
 
+#include <errno.h>
+#include <string.h>
+
 #include <pb_decode.h>
 #include <pb_encode.h>
 #include <zmk/studio/custom.h>
 #include <zmk/template/custom.pb.h>
+#include <zmk/template/rpc_view.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include <zmk/template/lazy_init.h>
+#include <zmk/template/rpc.h>
+#include <zmk/template/state.h>
+
+#include "async.h"
+#include "compress.h"
+#include "error.h"
+#include "notification.h"
+#include "power.h"
+#include "rpc_bench.h"
+#include "rpc_stats.h"
 
 #include <zephyr/logging/log.h>
 LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
@@ -35,8 +54,104 @@ ZMK_RPC_CUSTOM_SUBSYSTEM(zmk__template, &template_feature_meta,
 
 ZMK_RPC_CUSTOM_SUBSYSTEM_RESPONSE_BUFFER(zmk__template, zmk_template_Response);
 
-static int handle_sample_request(const zmk_template_SampleRequest *req,
-                                 zmk_template_Response *resp);
+// The message size limits in Kconfig set these struct sizes
+BUILD_ASSERT(sizeof(zmk_template_Request) <=
+                 CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_REQUEST_BUDGET,
+             "zmk_template_Request is over its RAM budget");
+BUILD_ASSERT(sizeof(zmk_template_Response) <=
+                 CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_RESPONSE_BUDGET,
+             "zmk_template_Response is over its RAM budget");
+BUILD_ASSERT(sizeof(zmk_template_Notification) <=
+                 CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_NOTIFICATION_BUDGET,
+             "zmk_template_Notification is over its RAM budget");
+
+static int handle_request(const zmk_template_Request *req,
+                          zmk_template_Response *resp);
+
+// Registered handlers indexed by Request.request_type tag
+static const struct zmk_template_rpc_handler
+    *handlers_by_tag[ZMK_TEMPLATE_RPC_MAX_TAG + 1];
+
+static int template_rpc_init(void) {
+  STRUCT_SECTION_FOREACH(zmk_template_rpc_handler, handler) {
+    if (handlers_by_tag[handler->tag]) {
+      LOG_ERR("Duplicate template RPC handler for tag %d", handler->tag);
+      continue;
+    }
+    handlers_by_tag[handler->tag] = handler;
+  }
+  return 0;
+}
+
+ZMK_TEMPLATE_LAZY_INIT(rpc_handlers, template_rpc_init);
+
+static const struct zmk_template_rpc_handler *find_handler(pb_size_t tag) {
+  return tag <= ZMK_TEMPLATE_RPC_MAX_TAG ? handlers_by_tag[tag] : NULL;
+}
+
+// Batch entries are referenced in place in the raw request payload
+static struct zmk_template_rpc_view batch_entry_views[ARRAY_SIZE(
+    ((zmk_template_BatchResponse *)0)->responses)];
+static struct zmk_template_rpc_views batch_entries = {
+    .items = batch_entry_views,
+    .capacity = ARRAY_SIZE(batch_entry_views),
+};
+
+/**
+ * Called by nanopb once the request type is known, before the request
+ * message itself is decoded. Binds zero-copy views to its bulk fields.
+ */
+static bool prepare_request_type(pb_istream_t *stream, const pb_field_t *field,
+                                 void **arg) {
+  // Storage for batch entries, NULL while decoding a batch entry
+  struct zmk_template_rpc_views *batch_views = *arg;
+
+  if (field->tag == zmk_template_Request_batch_tag) {
+    // Entries of the outer batch are still being iterated when an entry is
+    // decoded, so a nested batch must not rebind them.
+    if (!batch_views) {
+      PB_RETURN_ERROR(stream, "nested batch is not supported");
+    }
+    zmk_template_rpc_views_attach(
+        &((zmk_template_BatchRequest *)field->pData)->requests, batch_views);
+    return true;
+  }
+
+  const struct zmk_template_rpc_handler *handler = find_handler(field->tag);
+  if (handler && handler->prepare) {
+    handler->prepare(field->pData);
+  }
+  return true;
+}
+
+/**
+ * Decode a Request from `buf`. Bulk fields of the result reference `buf`.
+ */
+static bool decode_request(const uint8_t *buf, size_t len,
+                           zmk_template_Request *req, bool allow_batch) {
+  memset(req, 0, sizeof(*req));
+  req->cb_request_type.funcs.decode = prepare_request_type;
+  req->cb_request_type.arg = allow_batch ? &batch_entries : NULL;
+
+  pb_istream_t stream = pb_istream_from_buffer(buf, len);
+  if (!pb_decode(&stream, zmk_template_Request_fields, req)) {
+    LOG_WRN("Failed to decode template request: %s", PB_GET_ERROR(&stream));
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Decoded requests live here rather than on the Studio RPC thread stack. Calls
+ * are handled one at a time, so a single instance is reused for every call,
+ * and responses are built in place in the subsystem response buffer.
+ */
+static struct {
+  zmk_template_Request request;
+  // The batch entry being handled while `request` holds the batch itself
+  zmk_template_Request entry;
+  zmk_template_Response entry_response;
+} arena;
 
 /**
  * Main request handler for the custom RPC subsystem.
@@ -49,53 +164,178 @@ template_rpc_handle_request(const zmk_custom_CallRequest *raw_request,
       ZMK_RPC_CUSTOM_SUBSYSTEM_RESPONSE_BUFFER_ALLOCATE(zmk__template,
                                                         encode_response);
 
-  zmk_template_Request req = zmk_template_Request_init_zero;
+  zmk_template_Request *req = &arena.request;
+
+  // Includes the handler table, so it comes before decoding
+  zmk_template_lazy_init_all();
+  template_notification_set_subsystem_index(raw_request->subsystem_index);
+  template_rpc_stats_begin();
+  uint32_t start = template_rpc_stats_now();
 
   // Decode the incoming request from the raw payload
-  pb_istream_t req_stream = pb_istream_from_buffer(raw_request->payload.bytes,
-                                                   raw_request->payload.size);
-  if (!pb_decode(&req_stream, zmk_template_Request_fields, &req)) {
-    LOG_WRN("Failed to decode template request: %s", PB_GET_ERROR(&req_stream));
-    zmk_template_ErrorResponse err = zmk_template_ErrorResponse_init_zero;
-    snprintf(err.message, sizeof(err.message), "Failed to decode request");
-    resp->which_response_type = zmk_template_Response_error_tag;
-    resp->response_type.error = err;
+  if (!decode_request(raw_request->payload.bytes, raw_request->payload.size,
+                      req, true)) {
+    template_rpc_stats_decode_failure();
+    template_rpc_set_error(resp,
+                           zmk_template_ErrorCode_ERROR_CODE_DECODE_FAILED, 0,
+                           "Failed to decode request");
+    resp->request_id = req->request_id;
     return true;
   }
+  uint32_t decoded = template_rpc_stats_now();
 
-  int rc = 0;
-  switch (req.which_request_type) {
-  case zmk_template_Request_sample_tag:
-    rc = handle_sample_request(&req.request_type.sample, resp);
-    break;
-  default:
-    LOG_WRN("Unsupported template request type: %d", req.which_request_type);
-    rc = -1;
-  }
-
+  int rc = handle_request(req, resp);
   if (rc != 0) {
-    zmk_template_ErrorResponse err = zmk_template_ErrorResponse_init_zero;
-    snprintf(err.message, sizeof(err.message), "Failed to process request");
-    resp->which_response_type = zmk_template_Response_error_tag;
-    resp->response_type.error = err;
+    template_rpc_set_handler_error(resp, rc);
   }
+  resp->request_id = req->request_id;
+  // Batch entries share the state version of the batch response
+  resp->state_version = zmk_template_state_version();
+
+  template_rpc_stats_record_pending(
+      encode_response, req->which_request_type, decoded - start,
+      template_rpc_stats_now() - decoded,
+      resp->which_response_type == zmk_template_Response_error_tag);
   return true;
 }
 
+#if IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_BENCH) ||                \
+    IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_FUZZ)
+bool template_rpc_bench_call(const zmk_custom_CallRequest *raw_request,
+                             pb_callback_t *encode_response) {
+  return template_rpc_handle_request(raw_request, encode_response);
+}
+
+bool template_rpc_bench_decode(const zmk_custom_CallRequest *raw_request) {
+  zmk_template_lazy_init_all();
+  return decode_request(raw_request->payload.bytes, raw_request->payload.size,
+                        &arena.request, true);
+}
+#endif
+
+/**
+ * Whether `req` is bulk traffic to hold for now. Only bulk and async
+ * handlers are held, as they are made to run on the async work queue. Others
+ * may read zero-copy views of the payload, or state that only the RPC thread
+ * touches.
+ */
+static bool hold_request(const zmk_template_Request *req,
+                         const struct zmk_template_rpc_handler *handler) {
+  return req->qos == zmk_template_Qos_QOS_BULK &&
+         (handler->bulk || handler->async) && !template_power_bulk_allowed();
+}
+
+/**
+ * Dispatch a decoded request to its registered handler.
+ */
+static int handle_request(const zmk_template_Request *req,
+                          zmk_template_Response *resp) {
+  const struct zmk_template_rpc_handler *handler =
+      find_handler(req->which_request_type);
+  if (!handler) {
+    LOG_WRN("Unsupported template request type: %d", req->which_request_type);
+    return -ENOTSUP;
+  }
+  const bool hold = hold_request(req, handler);
+  if (handler->async || hold) {
+    return template_rpc_async_submit(handler, req, resp, hold);
+  }
+
+  int rc = handler->handle(req, resp);
+  if (rc == 0) {
+    template_rpc_compress_response(req, resp);
+  }
+  return rc;
+}
+
 /**
- * Handle the SampleRequest and populate the response.
+ * Handle the BatchRequest by running every sub-request in order and
+ * collecting the encoded responses. A failing entry produces an
+ * ErrorResponse in its slot and does not abort the remaining entries.
  */
-static int handle_sample_request(const zmk_template_SampleRequest *req,
-                                 zmk_template_Response *resp) {
-  LOG_DBG("Received sample request with value: %d", req->value);
+static int handle_batch_request(const zmk_template_BatchRequest *req,
+                                zmk_template_Response *resp) {
+  const struct zmk_template_rpc_views *entries =
+      zmk_template_rpc_views_get(&req->requests);
+
+  LOG_DBG("Received batch request with %zu entries", entries->count);
 
-  zmk_template_SampleResponse result = zmk_template_SampleResponse_init_zero;
+  zmk_template_BatchResponse *out = ZMK_TEMPLATE_RPC_RESPONSE(resp, batch);
 
-  // Create a simple response string based on the request value
-  snprintf(result.value, sizeof(result.value),
-           "Hello from firmware! Received: %d", req->value);
+  for (size_t i = 0; i < entries->count; i++) {
+    memset(&arena.entry_response, 0, sizeof(arena.entry_response));
+    uint32_t start = template_rpc_stats_now();
 
-  resp->which_response_type = zmk_template_Response_sample_tag;
-  resp->response_type.sample = result;
+    if (!decode_request(entries->items[i].data, entries->items[i].size,
+                        &arena.entry, false)) {
+      template_rpc_stats_decode_failure();
+      template_rpc_set_error(&arena.entry_response,
+                             zmk_template_ErrorCode_ERROR_CODE_DECODE_FAILED, 0,
+                             "Failed to decode request");
+      arena.entry.which_request_type = 0;
+    }
+    uint32_t decoded = template_rpc_stats_now();
+
+    if (arena.entry.which_request_type != 0) {
+      int rc = handle_request(&arena.entry, &arena.entry_response);
+      if (rc != 0) {
+        template_rpc_set_handler_error(&arena.entry_response, rc);
+      }
+    }
+    arena.entry_response.request_id = arena.entry.request_id;
+    uint32_t handled = template_rpc_stats_now();
+
+    pb_ostream_t ostream = pb_ostream_from_buffer(
+        out->responses[i].bytes, sizeof(out->responses[i].bytes));
+    if (!pb_encode(&ostream, zmk_template_Response_fields,
+                   &arena.entry_response)) {
+      // Typically a streamed response that does not fit in a batch slot
+      LOG_WRN("Failed to encode batch entry %zu: %s", i,
+              PB_GET_ERROR(&ostream));
+      template_rpc_set_error(
+          &arena.entry_response,
+          zmk_template_ErrorCode_ERROR_CODE_RESPONSE_TOO_LARGE, 0,
+          "Response too large for batch");
+      ostream = pb_ostream_from_buffer(out->responses[i].bytes,
+                                       sizeof(out->responses[i].bytes));
+      if (!pb_encode(&ostream, zmk_template_Response_fields,
+                     &arena.entry_response)) {
+        return -EMSGSIZE;
+      }
+    }
+    out->responses[i].size = ostream.bytes_written;
+    out->responses_count++;
+
+    if (arena.entry.which_request_type != 0) {
+      template_rpc_stats_record(arena.entry.which_request_type,
+                                decoded - start, handled - decoded,
+                                template_rpc_stats_now() - handled,
+                                arena.entry_response.which_response_type ==
+                                    zmk_template_Response_error_tag);
+    }
+  }
   return 0;
 }
+
+ZMK_TEMPLATE_RPC_HANDLER(batch, handle_batch_request);
+
+/**
+ * Echo a PingRequest with the device uptime. The handler does no other work,
+ * so the round trip the web UI measures is the transport and Studio's framing.
+ */
+static int handle_ping_request(const zmk_template_PingRequest *req,
+                               zmk_template_Response *resp) {
+  zmk_template_PingResponse *out = ZMK_TEMPLATE_RPC_RESPONSE(resp, ping);
+
+  out->sequence = req->sequence;
+  out->host_time_us = req->host_time_us;
+  out->device_cycles = IS_ENABLED(CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER)
+                           ? k_cycle_get_64()
+                           : k_cycle_get_32();
+  out->cycles_per_second = sys_clock_hw_cycles_per_sec();
+  memcpy(out->payload.bytes, req->payload.bytes, req->payload.size);
+  out->payload.size = req->payload.size;
+  return 0;
+}
+
+ZMK_TEMPLATE_RPC_HANDLER(ping, handle_ping_request);
@@ -0,0 +1,66 @@
+/**
+ * Template Feature - Error responses (internal)
+ *
+ * Errors are reported as an ErrorCode plus the errno of the failed handler.
+ * The text message is only sent with
+ * CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_ERROR_MESSAGES; otherwise these
+ * inline helpers drop it, so the strings do not end up in the image.
+ */
+
+#pragma once
+
+#include <errno.h>
+
+#include <zephyr/sys/util.h>
+
+#include <zmk/template/format.h>
+#include <zmk/template/rpc.h>
+
+/**
+ * ErrorCode reported for the negative errno `err` returned by a handler.
+ */
+static inline zmk_template_ErrorCode template_rpc_error_code(int err) {
+  switch (err) {
+  case -ENOTSUP:
+    return zmk_template_ErrorCode_ERROR_CODE_UNSUPPORTED;
+  case -EINVAL:
+    return zmk_template_ErrorCode_ERROR_CODE_INVALID_ARGUMENT;
+  case -ENOENT:
+    return zmk_template_ErrorCode_ERROR_CODE_NOT_FOUND;
+  case -EBUSY:
+    return zmk_template_ErrorCode_ERROR_CODE_BUSY;
+  case -EIO:
+    return zmk_template_ErrorCode_ERROR_CODE_IO;
+  default:
+    return zmk_template_ErrorCode_ERROR_CODE_HANDLER_FAILED;
+  }
+}
+
+/**
+ * Replace the response with an ErrorResponse. `err` is the negative errno a
+ * handler returned, or 0.
+ */
+static inline void template_rpc_set_error(zmk_template_Response *resp,
+                                          zmk_template_ErrorCode code, int err,
+                                          const char *message) {
+  zmk_template_ErrorResponse *out = ZMK_TEMPLATE_RPC_RESPONSE(resp, error);
+  out->code = code;
+  out->errno_value = err;
+#if IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_ERROR_MESSAGES)
+  struct zmk_template_fmt fmt;
+  zmk_template_fmt_init(&fmt, out->message, sizeof(out->message));
+  zmk_template_fmt_str(&fmt, message);
+#else
+  ARG_UNUSED(message);
+#endif
+}
+
+/**
+ * Replace the response with the ErrorResponse for a handler that returned the
+ * negative errno `err`.
+ */
+static inline void template_rpc_set_handler_error(zmk_template_Response *resp,
+                                                  int err) {
+  template_rpc_set_error(resp, template_rpc_error_code(err), err,
+                         "Failed to process request");
+}
@@ -0,0 +1,72 @@
+/**
+ * Template Feature - Allocation-free string formatting
+ */
+
+#include <string.h>
+
+#include <zmk/template/format.h>
+
+size_t zmk_template_utoa(uint32_t value, char *out) {
+  char digits[ZMK_TEMPLATE_ITOA_BUF_SIZE];
+  size_t count = 0;
+
+  do {
+    digits[count++] = '0' + value % 10;
+    value /= 10;
+  } while (value);
+
+  for (size_t i = 0; i < count; i++) {
+    out[i] = digits[count - 1 - i];
+  }
+  out[count] = '\0';
+  return count;
+}
+
+size_t zmk_template_itoa(int32_t value, char *out) {
+  if (value < 0) {
+    out[0] = '-';
+    // Negating in unsigned arithmetic keeps INT32_MIN defined
+    return 1 + zmk_template_utoa(0U - (uint32_t)value, out + 1);
+  }
+  return zmk_template_utoa(value, out);
+}
+
+void zmk_template_fmt_init(struct zmk_template_fmt *fmt, char *buf,
+                           size_t size) {
+  *fmt = (struct zmk_template_fmt){.buf = buf, .size = size};
+  if (size > 0) {
+    buf[0] = '\0';
+  }
+}
+
+static void fmt_append(struct zmk_template_fmt *fmt, const char *data,
+                       size_t len) {
+  if (fmt->size == 0) {
+    fmt->truncated = fmt->truncated || len > 0;
+    return;
+  }
+
+  // One byte is always kept for the NUL
+  const size_t room = fmt->size - 1 - fmt->len;
+  if (len > room) {
+    len = room;
+    fmt->truncated = true;
+  }
+  memcpy(&fmt->buf[fmt->len], data, len);
+  fmt->len += len;
+  fmt->buf[fmt->len] = '\0';
+}
+
+void zmk_template_fmt_str(struct zmk_template_fmt *fmt, const char *str) {
+  fmt_append(fmt, str, strlen(str));
+}
+
+void zmk_template_fmt_int(struct zmk_template_fmt *fmt, int32_t value) {
+  char digits[ZMK_TEMPLATE_ITOA_BUF_SIZE];
+  fmt_append(fmt, digits, zmk_template_itoa(value, digits));
+}
+
+void zmk_template_fmt_uint(struct zmk_template_fmt *fmt, uint32_t value) {
+  char digits[ZMK_TEMPLATE_ITOA_BUF_SIZE];
+  fmt_append(fmt, digits, zmk_template_utoa(value, digits));
+}
@@ -0,0 +1,139 @@
+/**
+ * Template Feature - Live key position stream
+ *
+ * While enabled through SetKeyEventsRequest, position state changes are
+ * appended to a packed KeyEventBatch and sent as a notification every
+ * CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_KEY_EVENTS_INTERVAL_MS. The listener
+ * only appends a few bytes under a spinlock, so it never holds up key
+ * processing; encoding and sending happen on the system work queue.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include <zmk/event_manager.h>
+#include <zmk/events/position_state_changed.h>
+#include <zmk/template/notification.h>
+#include <zmk/template/rpc.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#define INTERVAL                                                               \
+  K_MSEC(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_KEY_EVENTS_INTERVAL_MS)
+
+// Two varints of up to 5 bytes each
+#define MAX_EVENT_SIZE 10
+
+BUILD_ASSERT(sizeof(((zmk_template_KeyEventBatch *)0)->events.bytes) >=
+                 MAX_EVENT_SIZE,
+             "KEY_EVENT_BATCH_SIZE must fit at least one event");
+
+// Guards everything below
+static struct k_spinlock lock;
+static bool enabled;
+static zmk_template_KeyEventBatch batch;
+static int64_t last_event_ms;
+static uint32_t dropped;
+
+static size_t put_varint(uint8_t *out, uint32_t value) {
+  size_t len = 0;
+
+  do {
+    out[len] = value & 0x7f;
+    value >>= 7;
+    if (value) {
+      out[len] |= 0x80;
+    }
+    len++;
+  } while (value);
+  return len;
+}
+
+// Whether another event may not fit. Called with `lock` held.
+static bool batch_full(void) {
+  return (size_t)batch.events.size + MAX_EVENT_SIZE >
+         sizeof(batch.events.bytes);
+}
+
+static void flush_work_handler(struct k_work *work) {
+  zmk_template_Notification notification = {
+      .which_notification_type = zmk_template_Notification_key_events_tag,
+  };
+
+  k_spinlock_key_t key = k_spin_lock(&lock);
+  if (batch.count == 0 && dropped == 0) {
+    k_spin_unlock(&lock, key);
+    return;
+  }
+  notification.notification_type.key_events = batch;
+  notification.notification_type.key_events.dropped = dropped;
+  batch = (zmk_template_KeyEventBatch)zmk_template_KeyEventBatch_init_zero;
+  dropped = 0;
+  k_spin_unlock(&lock, key);
+
+  // Every batch carries different events, so none may replace another
+  zmk_template_notify_no_coalesce(&notification);
+}
+
+static K_WORK_DELAYABLE_DEFINE(flush_work, flush_work_handler);
+
+static int key_events_listener(const zmk_event_t *eh) {
+  const struct zmk_position_state_changed *ev =
+      as_zmk_position_state_changed(eh);
+  if (!ev) {
+    return ZMK_EV_EVENT_BUBBLE;
+  }
+
+  k_spinlock_key_t key = k_spin_lock(&lock);
+  if (!enabled) {
+    k_spin_unlock(&lock, key);
+    return ZMK_EV_EVENT_BUBBLE;
+  }
+
+  bool full = batch_full();
+  if (full) {
+    dropped++;
+  } else {
+    if (batch.count == 0) {
+      batch.start_ms = (uint32_t)ev->timestamp;
+      last_event_ms = ev->timestamp;
+    }
+    uint8_t *out = &batch.events.bytes[batch.events.size];
+    size_t len = put_varint(out, ev->position << 1 | ev->state);
+    len += put_varint(out + len, (uint32_t)(ev->timestamp - last_event_ms));
+    batch.events.size += len;
+    batch.count++;
+    last_event_ms = ev->timestamp;
+    full = batch_full();
+  }
+  k_spin_unlock(&lock, key);
+
+  if (full) {
+    k_work_reschedule(&flush_work, K_NO_WAIT);
+  } else {
+    // Leaves a scheduled flush alone, so batches go out once per INTERVAL
+    k_work_schedule(&flush_work, INTERVAL);
+  }
+  return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(template_key_events, key_events_listener);
+ZMK_SUBSCRIPTION(template_key_events, zmk_position_state_changed);
+
+static int handle_set_key_events(const zmk_template_SetKeyEventsRequest *req,
+                                 zmk_template_Response *resp) {
+  k_spinlock_key_t key = k_spin_lock(&lock);
+  enabled = req->enabled;
+  if (!enabled) {
+    batch = (zmk_template_KeyEventBatch)zmk_template_KeyEventBatch_init_zero;
+    dropped = 0;
+  }
+  k_spin_unlock(&lock, key);
+
+  LOG_DBG("Key event stream %s", req->enabled ? "enabled" : "disabled");
+  ZMK_TEMPLATE_RPC_RESPONSE(resp, set_key_events)->enabled = req->enabled;
+  return 0;
+}
+
+ZMK_TEMPLATE_RPC_HANDLER(set_key_events, handle_set_key_events);
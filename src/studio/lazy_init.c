@@ -0,0 +1,84 @@
+/**
+ * Template Feature - Lazy initialization
+ *
+ * Runs the initializers registered with ZMK_TEMPLATE_LAZY_INIT() on first use
+ * and, optionally, when ZMK Studio is unlocked.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/iterable_sections.h>
+#include <zephyr/sys/util.h>
+
+#include <zmk/template/lazy_init.h>
+
+#ifdef CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_LAZY_INIT_WARM_UP_ON_UNLOCK
+#include <zmk/event_manager.h>
+#include <zmk/studio/core.h>
+#endif
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+// Held while an initializer runs, so concurrent first uses wait for it
+static K_MUTEX_DEFINE(init_lock);
+
+// Set once every initializer ran
+static atomic_t all_done;
+
+int zmk_template_lazy_init_ensure(const struct zmk_template_lazy_init *entry) {
+  struct z_template_lazy_init_state *state = entry->state;
+
+  if (atomic_get(&state->done)) {
+    return state->rc;
+  }
+
+  k_mutex_lock(&init_lock, K_FOREVER);
+  if (!atomic_get(&state->done)) {
+    const uint32_t start = k_cycle_get_32();
+    state->rc = entry->init();
+    atomic_set(&state->done, 1);
+
+    if (state->rc != 0) {
+      LOG_ERR("Lazy init of %s failed: %d", entry->name, state->rc);
+    } else {
+      LOG_DBG("Lazy init of %s took %u us", entry->name,
+              k_cyc_to_us_floor32(k_cycle_get_32() - start));
+    }
+  }
+  k_mutex_unlock(&init_lock);
+  return state->rc;
+}
+
+void zmk_template_lazy_init_all(void) {
+  if (atomic_get(&all_done)) {
+    return;
+  }
+
+  STRUCT_SECTION_FOREACH(zmk_template_lazy_init, entry) {
+    zmk_template_lazy_init_ensure(entry);
+  }
+  atomic_set(&all_done, 1);
+}
+
+#ifdef CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_LAZY_INIT_WARM_UP_ON_UNLOCK
+
+static void warm_up(struct k_work *work) { zmk_template_lazy_init_all(); }
+
+static K_WORK_DEFINE(warm_up_work, warm_up);
+
+static int lock_state_listener(const zmk_event_t *eh) {
+  const struct zmk_studio_core_lock_state_changed *ev =
+      as_zmk_studio_core_lock_state_changed(eh);
+  // Only raised by &studio_unlock. Since this subsystem works while Studio
+  // is locked, the first RPC often comes earlier and has done the work.
+  if (ev && ev->state == ZMK_STUDIO_CORE_LOCK_STATE_UNLOCKED &&
+      !atomic_get(&all_done)) {
+    k_work_submit(&warm_up_work);
+  }
+  return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(template_lazy_init, lock_state_listener);
+ZMK_SUBSCRIPTION(template_lazy_init, zmk_studio_core_lock_state_changed);
+
+#endif
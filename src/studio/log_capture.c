@@ -0,0 +1,152 @@
+/**
+ * Template Feature - Log capture
+ *
+ * A log backend that keeps recent messages in a RAM ring buffer, so builds
+ * without a USB log backend can still be debugged from the web UI. Messages
+ * are not formatted here: a record keeps the cbprintf package the log core
+ * already built, i.e. the format string address and the raw arguments, and
+ * the web UI formats it. ReadLogsRequest drains the buffer oldest first.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log_backend.h>
+#include <zephyr/logging/log_core.h>
+#include <zephyr/logging/log_msg.h>
+#include <zephyr/logging/log_output.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/cbprintf.h>
+#include <zephyr/sys/ring_buffer.h>
+#include <zephyr/sys/util.h>
+
+#include <zmk/template/rpc.h>
+
+// uint32 timestamp, uint16 source ID, uint8 level, uint8 package length
+#define RECORD_HEADER_SIZE 8
+
+#define RECORDS_MAX_SIZE                                                       \
+  sizeof(((zmk_template_ReadLogsResponse *)0)->records.bytes)
+
+// Every record must fit a single ReadLogsResponse, or draining would stall
+#define MAX_PACKAGE_SIZE MIN(UINT8_MAX, RECORDS_MAX_SIZE - RECORD_HEADER_SIZE)
+
+BUILD_ASSERT(RECORDS_MAX_SIZE > RECORD_HEADER_SIZE,
+             "LOG_RECORDS_MAX_SIZE must fit a record header");
+
+#define BUFFER_SIZE                                                            \
+  CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_LOG_CAPTURE_BUFFER_SIZE
+
+RING_BUF_DECLARE(records, BUFFER_SIZE);
+
+// Guards `records` and `dropped`. The log core may call the backend from any
+// context in immediate mode.
+static struct k_spinlock lock;
+static uint32_t dropped;
+
+static size_t record_size(const uint8_t *header) {
+  return RECORD_HEADER_SIZE + header[7];
+}
+
+// Discard the oldest records until `size` bytes are free. Called with `lock`
+// held.
+static void make_room(size_t size) {
+  uint8_t header[RECORD_HEADER_SIZE];
+
+  while (ring_buf_space_get(&records) < size &&
+         ring_buf_peek(&records, header, sizeof(header)) == sizeof(header)) {
+    ring_buf_get(&records, NULL, record_size(header));
+    dropped++;
+  }
+}
+
+static uint16_t source_id(const void *source) {
+  if (!source) {
+    return UINT16_MAX;
+  }
+  return IS_ENABLED(CONFIG_LOG_RUNTIME_FILTERING)
+             ? log_dynamic_source_id((struct log_source_dynamic_data *)source)
+             : log_const_source_id(
+                   (const struct log_source_const_data *)source);
+}
+
+static void capture_process(const struct log_backend *const backend,
+                            union log_msg_generic *msg) {
+  struct log_msg *log = &msg->log;
+  uint8_t level = log_msg_get_level(log);
+
+  // Level 0 carries printk output routed through the log core
+  if (level == LOG_LEVEL_NONE ||
+      level > CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_LOG_CAPTURE_LEVEL) {
+    return;
+  }
+
+  // Hexdump data of the message is not kept
+  size_t len;
+  const uint8_t *package = log_msg_get_package(log, &len);
+
+  uint32_t timestamp_ms =
+      log_output_timestamp_to_us(log_msg_get_timestamp(log)) / USEC_PER_MSEC;
+
+  uint8_t header[RECORD_HEADER_SIZE];
+  sys_put_le32(timestamp_ms, header);
+  sys_put_le16(source_id(log_msg_get_source(log)), &header[4]);
+  header[6] = level;
+  header[7] = (uint8_t)len;
+
+  k_spinlock_key_t key = k_spin_lock(&lock);
+  if (len > MAX_PACKAGE_SIZE ||
+      RECORD_HEADER_SIZE + len > ring_buf_capacity_get(&records)) {
+    dropped++;
+  } else {
+    make_room(RECORD_HEADER_SIZE + len);
+    ring_buf_put(&records, header, sizeof(header));
+    ring_buf_put(&records, package, len);
+  }
+  k_spin_unlock(&lock, key);
+}
+
+static void capture_dropped(const struct log_backend *const backend,
+                            uint32_t count) {
+  k_spinlock_key_t key = k_spin_lock(&lock);
+  dropped += count;
+  k_spin_unlock(&lock, key);
+}
+
+// Records stay in RAM and are read once the device is up again, if at all
+static void capture_panic(const struct log_backend *const backend) {}
+
+static const struct log_backend_api capture_api = {
+    .process = capture_process,
+    .dropped = capture_dropped,
+    .panic = capture_panic,
+};
+
+LOG_BACKEND_DEFINE(template_log_capture, capture_api, true);
+
+static int handle_read_logs(const zmk_template_ReadLogsRequest *req,
+                            zmk_template_Response *resp) {
+  zmk_template_ReadLogsResponse *out =
+      ZMK_TEMPLATE_RPC_RESPONSE(resp, read_logs);
+  uint8_t header[RECORD_HEADER_SIZE];
+
+  k_spinlock_key_t key = k_spin_lock(&lock);
+  while (ring_buf_peek(&records, header, sizeof(header)) == sizeof(header)) {
+    size_t size = record_size(header);
+    if (out->records.size + size > sizeof(out->records.bytes)) {
+      out->more = true;
+      break;
+    }
+    ring_buf_get(&records, &out->records.bytes[out->records.size], size);
+    out->records.size += size;
+  }
+  out->dropped = dropped;
+  dropped = 0;
+  k_spin_unlock(&lock, key);
+
+  // The web UI needs both to find the arguments in a package
+  out->package_header_words =
+      sizeof(union cbprintf_package_hdr) / sizeof(uint32_t);
+  out->package_args_tagged = IS_ENABLED(CONFIG_LOG_USE_TAGGED_ARGUMENTS);
+  return 0;
+}
+
+ZMK_TEMPLATE_RPC_BULK_HANDLER(read_logs, handle_read_logs);
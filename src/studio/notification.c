@@ -0,0 +1,248 @@
+/**
+ * Template Feature - Notifications
+ *
+ * Notifications are encoded by the caller into a bounded ring buffer and sent
+ * from the system work queue as custom subsystem notifications of ZMK Studio.
+ *
+ * Sending is deferred by a short window. A notification queued while another
+ * one of the same kind (oneof member) is still waiting replaces it, so a burst
+ * of state updates costs a single transfer carrying the latest state.
+ *
+ * Urgent notifications are sent at once. Bulk ones are held in a queue of
+ * their own while the keyboard is idle on battery.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <pb_encode.h>
+#include <zephyr/kernel.h>
+
+#include <zmk/event_manager.h>
+#include <zmk/studio/custom.h>
+#include <zmk/studio/rpc.h>
+#include <zmk/template/notification.h>
+
+#include "notification.h"
+#include "power.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#define QUEUE_SIZE                                                             \
+  CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_NOTIFICATION_QUEUE_SIZE
+#define COALESCE_WINDOW                                                        \
+  K_MSEC(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_NOTIFICATION_COALESCE_MS)
+
+// Notifications are sent as the payload of a Studio CustomNotification
+#define ENCODED_MAX_SIZE                                                       \
+  MIN(zmk_template_Notification_size,                                          \
+      sizeof(((zmk_custom_CustomNotification *)0)->payload.bytes))
+
+struct encoded_notification {
+  pb_size_t kind;
+  bool coalesce;
+  size_t size;
+  uint8_t bytes[ENCODED_MAX_SIZE];
+};
+
+// Ring buffer of notifications, guarded by `lock`
+struct notification_queue {
+  struct encoded_notification *items;
+  size_t capacity;
+  size_t head;
+  size_t len;
+};
+
+// Waiting to be sent
+static struct encoded_notification pending_items[QUEUE_SIZE];
+static struct notification_queue pending = {
+    .items = pending_items,
+    .capacity = QUEUE_SIZE,
+};
+
+#if IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_POWER_SAVE)
+// Bulk notifications waiting for the keyboard to be active or on USB power
+static struct encoded_notification held_items
+    [CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_POWER_SAVE_HELD_NOTIFICATIONS];
+static struct notification_queue held = {
+    .items = held_items,
+    .capacity = ARRAY_SIZE(held_items),
+};
+#endif
+
+static struct k_spinlock lock;
+
+static struct template_notification_counters counters;
+
+static atomic_t subsystem_index = ATOMIC_INIT(-1);
+
+void template_notification_set_subsystem_index(uint32_t index) {
+  atomic_set(&subsystem_index, index);
+}
+
+void template_notification_get_counters(
+    struct template_notification_counters *out) {
+  k_spinlock_key_t key = k_spin_lock(&lock);
+  *out = counters;
+  k_spin_unlock(&lock, key);
+}
+
+/**
+ * Queue bulk notifications are added to and sent from, NULL when they are
+ * not held.
+ */
+static struct notification_queue *held_queue(void) {
+#if IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_POWER_SAVE)
+  return &held;
+#else
+  return NULL;
+#endif
+}
+
+/**
+ * Slot for `encoded` in `q`: the one of a queued notification it replaces,
+ * else a new one at the tail, NULL once full. Called with `lock` held.
+ */
+static struct encoded_notification *
+claim_slot(struct notification_queue *q,
+           const struct encoded_notification *encoded) {
+  if (encoded->coalesce) {
+    for (size_t i = 0; i < q->len; i++) {
+      struct encoded_notification *queued =
+          &q->items[(q->head + i) % q->capacity];
+      if (queued->coalesce && queued->kind == encoded->kind) {
+        counters.coalesced++;
+        return queued;
+      }
+    }
+  }
+  if (q->len < q->capacity) {
+    return &q->items[(q->head + q->len++) % q->capacity];
+  }
+  return NULL;
+}
+
+// Called with `lock` held
+static bool pop_from(struct notification_queue *q,
+                     struct encoded_notification *out) {
+  if (!q || q->len == 0) {
+    return false;
+  }
+  *out = q->items[q->head];
+  q->head = (q->head + 1) % q->capacity;
+  q->len--;
+  return true;
+}
+
+static bool pop_notification(struct encoded_notification *out) {
+  k_spinlock_key_t key = k_spin_lock(&lock);
+  // Held notifications are the older ones
+  bool found = (template_power_bulk_allowed() && pop_from(held_queue(), out)) ||
+               pop_from(&pending, out);
+  if (found) {
+    counters.sent++;
+  }
+  k_spin_unlock(&lock, key);
+  return found;
+}
+
+static void send_notifications(struct k_work *work) {
+  struct encoded_notification encoded;
+  const uint32_t index = atomic_get(&subsystem_index);
+
+  while (pop_notification(&encoded)) {
+    zmk_custom_CustomNotification custom = {
+        .subsystem_index = index,
+    };
+    memcpy(custom.payload.bytes, encoded.bytes, encoded.size);
+    custom.payload.size = encoded.size;
+
+    raise_zmk_studio_rpc_notification((struct zmk_studio_rpc_notification){
+        .notification =
+            ZMK_RPC_NOTIFICATION(custom, custom_notification, custom)});
+  }
+}
+
+static K_WORK_DELAYABLE_DEFINE(send_notifications_work, send_notifications);
+
+void template_notification_release_held(void) {
+  // Held notifications join the next send, or start one
+  k_work_schedule(&send_notifications_work, K_NO_WAIT);
+}
+
+static int queue_notification(const zmk_template_Notification *notification,
+                              bool coalesce) {
+  if (atomic_get(&subsystem_index) < 0) {
+    return -ENOTCONN;
+  }
+
+  size_t size;
+  if (!pb_get_encoded_size(&size, zmk_template_Notification_fields,
+                           notification)) {
+    return -EINVAL;
+  }
+  if (size > ENCODED_MAX_SIZE) {
+    return -EMSGSIZE;
+  }
+
+  struct encoded_notification encoded = {
+      .kind = notification->which_notification_type,
+      .coalesce = coalesce,
+  };
+  pb_ostream_t stream =
+      pb_ostream_from_buffer(encoded.bytes, sizeof(encoded.bytes));
+  if (!pb_encode(&stream, zmk_template_Notification_fields, notification)) {
+    LOG_WRN("Failed to encode notification: %s", PB_GET_ERROR(&stream));
+    return -EINVAL;
+  }
+  encoded.size = stream.bytes_written;
+
+  const bool hold = notification->qos == zmk_template_Qos_QOS_BULK &&
+                    held_queue() && !template_power_bulk_allowed();
+
+  int rc = 0;
+  k_spinlock_key_t key = k_spin_lock(&lock);
+
+  struct encoded_notification *slot =
+      claim_slot(hold ? held_queue() : &pending, &encoded);
+  if (slot) {
+    *slot = encoded;
+  } else {
+    counters.dropped++;
+    rc = -ENOMEM;
+  }
+
+  k_spin_unlock(&lock, key);
+
+  if (rc != 0) {
+    LOG_DBG("Notification queue full, dropping notification");
+    return rc;
+  }
+  if (hold) {
+    // Sent by template_notification_release_held(), unless bulk traffic was
+    // allowed again meanwhile
+    if (template_power_bulk_allowed()) {
+      template_notification_release_held();
+    }
+    return 0;
+  }
+  if (notification->qos == zmk_template_Qos_QOS_URGENT) {
+    // Takes the notifications waiting for the window along
+    k_work_reschedule(&send_notifications_work, K_NO_WAIT);
+    return 0;
+  }
+  // Does nothing if already scheduled, so the window starts with the first
+  // notification of a burst.
+  k_work_schedule(&send_notifications_work, COALESCE_WINDOW);
+  return 0;
+}
+
+int zmk_template_notify(const zmk_template_Notification *notification) {
+  return queue_notification(notification, true);
+}
+
+int zmk_template_notify_no_coalesce(
+    const zmk_template_Notification *notification) {
+  return queue_notification(notification, false);
+}
@@ -0,0 +1,46 @@
+/**
+ * Template Feature - Notifications (internal)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <zephyr/sys/util.h>
+
+struct template_notification_counters {
+  uint32_t sent;
+  // Replaced by a newer notification of the same kind before being sent
+  uint32_t coalesced;
+  // Rejected because the queue was full
+  uint32_t dropped;
+};
+
+#if IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_NOTIFICATIONS)
+
+/**
+ * Remember the Studio subsystem index assigned to this module, which
+ * addresses notifications to the web UI. Learned from each request.
+ */
+void template_notification_set_subsystem_index(uint32_t index);
+
+void template_notification_get_counters(
+    struct template_notification_counters *out);
+
+/**
+ * Send the held bulk notifications, once bulk traffic is allowed.
+ */
+void template_notification_release_held(void);
+
+#else
+
+static inline void template_notification_set_subsystem_index(uint32_t index) {}
+
+static inline void
+template_notification_get_counters(struct template_notification_counters *out) {
+  *out = (struct template_notification_counters){0};
+}
+
+static inline void template_notification_release_held(void) {}
+
+#endif
@@ -0,0 +1,76 @@
+/**
+ * Template Feature - Power-aware traffic
+ *
+ * Tracks whether bulk traffic may be sent and releases what was held for it
+ * once the keyboard becomes active or is plugged into USB.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include <zmk/activity.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/activity_state_changed.h>
+
+#if IS_ENABLED(CONFIG_USB_DEVICE_STACK)
+#include <zmk/events/usb_conn_state_changed.h>
+#include <zmk/usb.h>
+#endif
+
+#include "async.h"
+#include "notification.h"
+#include "power.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+static bool usb_powered(void) {
+#if IS_ENABLED(CONFIG_USB_DEVICE_STACK)
+  return zmk_usb_is_powered();
+#else
+  return false;
+#endif
+}
+
+#if IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_BENCH)
+static atomic_t bench_idle;
+#endif
+
+bool template_power_bulk_allowed(void) {
+#if IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_BENCH)
+  if (atomic_get(&bench_idle)) {
+    return false;
+  }
+#endif
+  return zmk_activity_get_state() == ZMK_ACTIVITY_ACTIVE || usb_powered();
+}
+
+static void release_held(void) {
+  LOG_DBG("Releasing held bulk traffic");
+  template_rpc_async_release_held();
+  template_notification_release_held();
+}
+
+#if IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_BENCH)
+void template_power_bench_set_idle(bool idle) {
+  atomic_set(&bench_idle, idle);
+  if (template_power_bulk_allowed()) {
+    release_held();
+  }
+}
+#endif
+
+static int power_listener(const zmk_event_t *eh) {
+  // The radio is busy with key reports while active, and power is not a
+  // concern on USB, so held traffic goes out along with it
+  if (template_power_bulk_allowed()) {
+    release_held();
+  }
+  return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(template_power, power_listener);
+ZMK_SUBSCRIPTION(template_power, zmk_activity_state_changed);
+#if IS_ENABLED(CONFIG_USB_DEVICE_STACK)
+ZMK_SUBSCRIPTION(template_power, zmk_usb_conn_state_changed);
+#endif
@@ -0,0 +1,38 @@
+/**
+ * Template Feature - Power-aware traffic (internal)
+ *
+ * Bulk requests and notifications are held while the keyboard is idle on
+ * battery, so they do not wake the radio on their own, and go out together
+ * once ZMK reports activity or USB power.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include <zephyr/sys/util.h>
+
+#if IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_POWER_SAVE)
+
+/**
+ * Whether bulk traffic may be sent now: the keyboard is active or on USB
+ * power.
+ */
+bool template_power_bulk_allowed(void);
+
+#if IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_BENCH)
+
+/**
+ * Treat the keyboard as idle on battery while `idle`, whatever ZMK reports,
+ * and release what was held once cleared. Lets the benchmark hold requests
+ * without waiting for the idle timeout.
+ */
+void template_power_bench_set_idle(bool idle);
+
+#endif
+
+#else
+
+static inline bool template_power_bulk_allowed(void) { return true; }
+
+#endif
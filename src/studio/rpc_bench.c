@@ -0,0 +1,346 @@
+/**
+ * Template Feature - RPC throughput benchmark
+ *
+ * Runs once at boot on native_posix. Every case encodes a request, feeds it
+ * to the subsystem handler the same way the Studio RPC thread does, and
+ * encodes the response into a CallResponse. Time runs on the host clock, as
+ * simulated time does not advance while code runs on native_posix.
+ *
+ * Measurements vary from run to run, so every case also logs a "verdict" line
+ * that only changes on failure or regression. tests/studio_bench compares
+ * those against its snapshot.
+ *
+ * With CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_POWER_SAVE, bulk requests are
+ * then sent while the keyboard is made to look idle, to check that they are
+ * held and that their job result decodes once released.
+ */
+
+#include <string.h>
+
+#include <native_rtc.h>
+#include <pb_decode.h>
+#include <pb_encode.h>
+#include <zephyr/kernel.h>
+#include <zmk/studio/custom.h>
+#include <zmk/template/custom.pb.h>
+
+#include "power.h"
+#include "rpc_bench.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#define ITERATIONS CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_BENCH_ITERATIONS
+#define STACK_SIZE CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_BENCH_STACK_SIZE
+#define MIN_REQUESTS_PER_SEC                                                   \
+  CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_BENCH_MIN_REQUESTS_PER_SEC
+#define MAX_STACK CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_BENCH_MAX_STACK
+#define MAX_DECODE_NS                                                          \
+  (CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_BENCH_MAX_DECODE_US * NSEC_PER_USEC)
+#define MAX_ENCODE_NS                                                          \
+  (CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_BENCH_MAX_ENCODE_US * NSEC_PER_USEC)
+
+// Per-call average of `total_us`, as whole and thousandths of microseconds
+#define PER_CALL_US(total_us)                                                  \
+  (uint32_t)((total_us) / ITERATIONS),                                         \
+      (uint32_t)((total_us) * 1000 / ITERATIONS % 1000)
+#define PER_CALL_NS(total_us) ((total_us) * NSEC_PER_USEC / ITERATIONS)
+
+#define BATCH_ENTRIES ARRAY_SIZE(((zmk_template_BatchResponse *)0)->responses)
+#define STREAM_RECORDS 32
+
+struct bench_case {
+  const char *name;
+  void (*build)(zmk_template_Request *req, int32_t value);
+};
+
+static void build_sample(zmk_template_Request *req, int32_t value) {
+  req->which_request_type = zmk_template_Request_sample_tag;
+  req->request_type.sample.value = value;
+}
+
+static bool encode_batch_entries(pb_ostream_t *stream, const pb_field_t *field,
+                                 void *const *arg) {
+  const int32_t value = *(const int32_t *)*arg;
+
+  for (size_t i = 0; i < BATCH_ENTRIES; i++) {
+    zmk_template_Request entry = zmk_template_Request_init_zero;
+    build_sample(&entry, value + i);
+
+    uint8_t buf[zmk_template_SampleRequest_size + 8];
+    pb_ostream_t entry_stream = pb_ostream_from_buffer(buf, sizeof(buf));
+    if (!pb_encode(&entry_stream, zmk_template_Request_fields, &entry)) {
+      return false;
+    }
+    if (!pb_encode_tag_for_field(stream, field) ||
+        !pb_encode_string(stream, buf, entry_stream.bytes_written)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static int32_t batch_value;
+
+static void build_batch(zmk_template_Request *req, int32_t value) {
+  batch_value = value;
+  req->which_request_type = zmk_template_Request_batch_tag;
+  req->request_type.batch.requests.funcs.encode = encode_batch_entries;
+  req->request_type.batch.requests.arg = &batch_value;
+}
+
+static void build_sample_stream(zmk_template_Request *req, int32_t value) {
+  req->which_request_type = zmk_template_Request_sample_stream_tag;
+  req->request_type.sample_stream.count = STREAM_RECORDS;
+  req->request_type.sample_stream.start = value;
+}
+
+static const struct bench_case cases[] = {
+    {.name = "sample", .build = build_sample},
+    {.name = "batch", .build = build_batch},
+    {.name = "sample_stream", .build = build_sample_stream},
+};
+
+static zmk_custom_CallRequest call_request;
+static uint8_t response_buf[1024];
+
+static bool encode_request(const char *name, const zmk_template_Request *req) {
+  pb_ostream_t stream = pb_ostream_from_buffer(
+      call_request.payload.bytes, sizeof(call_request.payload.bytes));
+  if (!pb_encode(&stream, zmk_template_Request_fields, req)) {
+    LOG_ERR("Failed to encode %s request: %s", name, PB_GET_ERROR(&stream));
+    return false;
+  }
+  call_request.payload.size = stream.bytes_written;
+  return true;
+}
+
+static bool encode_call_request(const struct bench_case *bench,
+                                int32_t value) {
+  zmk_template_Request req = zmk_template_Request_init_zero;
+  bench->build(&req, value);
+  return encode_request(bench->name, &req);
+}
+
+static uint64_t now_us(void) {
+  return native_rtc_gettime_us(RTC_CLOCK_REALTIME);
+}
+
+static void bench_verdict(const char *name, const char *verdict) {
+  LOG_INF("verdict %s: %s", name, verdict);
+}
+
+static void phase_verdict(const char *name, const char *phase,
+                          uint64_t total_us, uint64_t max_ns) {
+  LOG_INF("verdict %s %s: %s", name, phase,
+          PER_CALL_NS(total_us) > max_ns ? "time regression" : "ok");
+}
+
+static void run_case(const struct bench_case *bench) {
+  uint64_t decode_us = 0;
+  uint64_t call_us = 0;
+  uint64_t encode_us = 0;
+  size_t request_bytes = 0;
+  size_t response_bytes = 0;
+  size_t failures = 0;
+
+  const uint64_t begin = now_us();
+  for (int i = 0; i < ITERATIONS; i++) {
+    // Values vary so that varint sizes differ across the run
+    if (!encode_call_request(bench, i * 37)) {
+      bench_verdict(bench->name, "encode failed");
+      return;
+    }
+    request_bytes += call_request.payload.size;
+
+    zmk_custom_CallResponse call_response = zmk_custom_CallResponse_init_zero;
+
+    // Decoded once on its own, then again by the call, which also handles it
+    const uint64_t t0 = now_us();
+    bool ok = template_rpc_bench_decode(&call_request);
+    const uint64_t t1 = now_us();
+    ok = ok && template_rpc_bench_call(&call_request, &call_response.payload);
+    const uint64_t t2 = now_us();
+
+    pb_ostream_t stream =
+        pb_ostream_from_buffer(response_buf, sizeof(response_buf));
+    ok = ok &&
+         pb_encode(&stream, zmk_custom_CallResponse_fields, &call_response);
+    const uint64_t t3 = now_us();
+
+    if (!ok) {
+      failures++;
+    }
+    decode_us += t1 - t0;
+    call_us += t2 - t1;
+    encode_us += t3 - t2;
+    response_bytes += stream.bytes_written;
+  }
+  const uint64_t handle_us = call_us > decode_us ? call_us - decode_us : 0;
+  // The separate decode is left out, so this is the rate of real calls
+  const uint64_t elapsed_us = MAX(now_us() - begin - decode_us, 1);
+
+  const uint32_t requests_per_sec =
+      (uint64_t)ITERATIONS * USEC_PER_SEC / elapsed_us;
+  LOG_INF("%s: %u req/s, decode %u.%03u us, handle %u.%03u us, "
+          "encode %u.%03u us, request %zu B, response %zu B",
+          bench->name, requests_per_sec, PER_CALL_US(decode_us),
+          PER_CALL_US(handle_us), PER_CALL_US(encode_us),
+          request_bytes / ITERATIONS, response_bytes / ITERATIONS);
+
+  if (failures > 0) {
+    LOG_ERR("%s: %zu of %d calls failed", bench->name, failures, ITERATIONS);
+    bench_verdict(bench->name, "calls failed");
+  } else if (requests_per_sec < MIN_REQUESTS_PER_SEC) {
+    bench_verdict(bench->name, "throughput regression");
+  } else {
+    bench_verdict(bench->name, "ok");
+  }
+  if (failures == 0) {
+    phase_verdict(bench->name, "decode", decode_us, MAX_DECODE_NS);
+    phase_verdict(bench->name, "encode", encode_us, MAX_ENCODE_NS);
+  }
+}
+
+#if IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_POWER_SAVE)
+
+#define HELD_REQUEST_ID 7
+// 1 ms polls of a released job before it counts as lost
+#define HELD_JOB_POLLS 100
+
+struct held_case {
+  const char *name;
+  pb_size_t request_tag;
+  pb_size_t response_tag;
+};
+
+static const struct held_case held_cases[] = {
+    {.name = "held_usage_stats",
+     .request_tag = zmk_template_Request_get_usage_stats_tag,
+     .response_tag = zmk_template_Response_usage_stats_tag},
+#if IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_LOG_CAPTURE)
+    {.name = "held_read_logs",
+     .request_tag = zmk_template_Request_read_logs_tag,
+     .response_tag = zmk_template_Response_read_logs_tag},
+#endif
+};
+
+// Response to a call, and the job response decoded from its JobResult
+static zmk_template_Response call_response;
+static zmk_template_Response job_response;
+
+static bool decode_payload(pb_istream_t *stream, const pb_field_t *field,
+                           void **arg) {
+  return pb_decode(stream, zmk_template_Response_fields, *arg);
+}
+
+// Send `req` through the handler and decode its response into call_response
+static bool call_decoded(const char *name, const zmk_template_Request *req) {
+  if (!encode_request(name, req)) {
+    return false;
+  }
+
+  zmk_custom_CallResponse raw = zmk_custom_CallResponse_init_zero;
+  if (!template_rpc_bench_call(&call_request, &raw.payload)) {
+    return false;
+  }
+  pb_ostream_t out = pb_ostream_from_buffer(response_buf, sizeof(response_buf));
+  if (!pb_encode(&out, zmk_custom_CallResponse_fields, &raw)) {
+    return false;
+  }
+
+  zmk_custom_CallResponse decoded = zmk_custom_CallResponse_init_zero;
+  decoded.payload.funcs.decode = decode_payload;
+  decoded.payload.arg = &call_response;
+  memset(&call_response, 0, sizeof(call_response));
+  pb_istream_t in = pb_istream_from_buffer(response_buf, out.bytes_written);
+  return pb_decode(&in, zmk_custom_CallResponse_fields, &decoded);
+}
+
+// Fetch the result of `job_id` into call_response
+static bool get_job_result(uint32_t job_id) {
+  zmk_template_Request req = zmk_template_Request_init_zero;
+  req.which_request_type = zmk_template_Request_get_job_result_tag;
+  req.request_type.get_job_result.job_id = job_id;
+  return call_decoded("get_job_result", &req) &&
+         call_response.which_response_type ==
+             zmk_template_Response_job_result_tag;
+}
+
+static const char *run_held_case(const struct held_case *held) {
+  zmk_template_Request req = zmk_template_Request_init_zero;
+  req.which_request_type = held->request_tag;
+  req.request_id = HELD_REQUEST_ID;
+  req.qos = zmk_template_Qos_QOS_BULK;
+  req.accept_compression = zmk_template_Compression_COMPRESSION_RLE;
+
+  template_power_bench_set_idle(true);
+  if (!call_decoded(held->name, &req)) {
+    template_power_bench_set_idle(false);
+    return "call failed";
+  }
+  if (call_response.which_response_type != zmk_template_Response_pending_tag) {
+    template_power_bench_set_idle(false);
+    return "not held";
+  }
+  const uint32_t job_id = call_response.response_type.pending.job_id;
+  const bool waited = get_job_result(job_id) &&
+                      !call_response.response_type.job_result.done;
+  template_power_bench_set_idle(false);
+  if (!waited) {
+    return "ran while idle";
+  }
+
+  bool done = false;
+  for (int i = 0; i < HELD_JOB_POLLS && !done; i++) {
+    k_msleep(1);
+    done = get_job_result(job_id) &&
+           call_response.response_type.job_result.done;
+  }
+  if (!done) {
+    return "not released";
+  }
+
+  const zmk_template_JobResult *result =
+      &call_response.response_type.job_result;
+  pb_istream_t stream =
+      pb_istream_from_buffer(result->response.bytes, result->response.size);
+  memset(&job_response, 0, sizeof(job_response));
+  if (!pb_decode(&stream, zmk_template_Response_fields, &job_response)) {
+    return "result undecodable";
+  }
+  if (job_response.which_response_type != held->response_tag ||
+      job_response.request_id != HELD_REQUEST_ID) {
+    LOG_ERR("%s: job answered with response %d", held->name,
+            job_response.which_response_type);
+    return "wrong result";
+  }
+  LOG_INF("%s: result %u B", held->name, result->response.size);
+  return "ok";
+}
+
+#endif
+
+static void rpc_bench_thread(void *p1, void *p2, void *p3) {
+  for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+    run_case(&cases[i]);
+  }
+
+#if IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_POWER_SAVE)
+  for (size_t i = 0; i < ARRAY_SIZE(held_cases); i++) {
+    bench_verdict(held_cases[i].name, run_held_case(&held_cases[i]));
+  }
+#endif
+
+  size_t unused = 0;
+  if (k_thread_stack_space_get(k_current_get(), &unused) != 0) {
+    bench_verdict("stack", "unknown");
+    return;
+  }
+  const size_t peak = STACK_SIZE - unused;
+  LOG_INF("stack: peak %zu of %d B", peak, STACK_SIZE);
+  bench_verdict("stack", peak > MAX_STACK ? "over budget" : "ok");
+}
+
+K_THREAD_DEFINE(template_rpc_bench, STACK_SIZE, rpc_bench_thread, NULL, NULL,
+                NULL, K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
@@ -0,0 +1,24 @@
+/**
+ * Template Feature - RPC benchmark and fuzz harness (internal)
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include <pb.h>
+#include <zmk/studio/custom.h>
+
+/**
+ * Entry point of the subsystem request handler, exposed for the benchmark
+ * and the fuzz harness since the subsystem registration keeps it private.
+ */
+bool template_rpc_bench_call(const zmk_custom_CallRequest *raw_request,
+                             pb_callback_t *encode_response);
+
+/**
+ * Decode `raw_request` like the handler does, without handling it, so the
+ * benchmark can time decoding apart from the handler. The entries of a batch
+ * are decoded by its handler, not here.
+ */
+bool template_rpc_bench_decode(const zmk_custom_CallRequest *raw_request);
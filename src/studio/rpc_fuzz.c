@@ -0,0 +1,480 @@
+/**
+ * Template Feature - RPC decoder fuzz and load harness
+ *
+ * Runs once at boot on native_posix. Every case generates request payloads,
+ * random, mutated from valid requests or crafted to hit the costly decode
+ * paths, and feeds them to the subsystem handler the same way the Studio RPC
+ * thread does. Each response is then encoded the way the transport streams
+ * it. A case fails when a call is rejected, or when a single call takes
+ * longer than CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_FUZZ_MAX_CALL_US, which
+ * would stall the RPC thread.
+ *
+ * Random and mutated payloads that would reach a state-changing handler, at
+ * the top level or as a batch entry, are generated again. Otherwise a case
+ * would open transfer sessions, write settings, queue async jobs or reset
+ * counters, and the calls after it would measure that state, not decoding.
+ *
+ * Inputs come from a PRNG seeded from Kconfig, so a failing run can be
+ * repeated. As with rpc_bench.c, only the "verdict" lines are compared by
+ * tests/studio_fuzz, since timings vary from run to run.
+ */
+
+#include <string.h>
+
+#include <native_rtc.h>
+#include <pb_decode.h>
+#include <pb_encode.h>
+#include <zephyr/kernel.h>
+#include <zmk/studio/custom.h>
+#include <zmk/template/custom.pb.h>
+
+#include "rpc_bench.h"
+
+#include <zephyr/logging/log.h>
+// The handler warns about every malformed request, so the test keeps the zmk
+// log quiet and this module reports at its own level
+LOG_MODULE_REGISTER(template_rpc_fuzz, LOG_LEVEL_INF);
+
+#define ITERATIONS CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_FUZZ_ITERATIONS
+#define STACK_SIZE CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_FUZZ_STACK_SIZE
+#define MAX_CALL_US CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_FUZZ_MAX_CALL_US
+#define MAX_STACK CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_FUZZ_MAX_STACK
+
+#define PAYLOAD_SIZE sizeof(((zmk_custom_CallRequest *)0)->payload.bytes)
+#define BATCH_ENTRIES ARRAY_SIZE(((zmk_template_BatchResponse *)0)->responses)
+
+// Field numbers used by the crafted requests, see custom.proto
+#define REQUEST_SAMPLE 1
+#define REQUEST_BATCH 2
+#define REQUEST_ID 15
+#define REQUEST_PING 20
+#define BATCH_REQUESTS 1
+#define PING_PAYLOAD 3
+// Not used by any message, so it is skipped by the decoder
+#define UNKNOWN_FIELD 1000
+
+// Writes a payload of at most PAYLOAD_SIZE bytes for iteration `i` into `buf`
+// and returns its size
+typedef size_t (*fuzz_build_fn)(uint8_t *buf, uint32_t i);
+
+struct fuzz_case {
+  const char *name;
+  fuzz_build_fn build;
+};
+
+static uint32_t rng_state = CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_FUZZ_SEED;
+
+// xorshift32, reproducible for a given seed
+static uint32_t rng_next(void) {
+  uint32_t x = rng_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  rng_state = x;
+  return x;
+}
+
+static uint32_t rng_below(uint32_t bound) { return rng_next() % bound; }
+
+/**
+ * Valid requests the mutating and truncating cases start from, encoded once.
+ */
+struct fuzz_seed {
+  uint8_t bytes[PAYLOAD_SIZE];
+  size_t size;
+};
+
+static struct fuzz_seed seeds[6];
+static size_t seed_count;
+
+static void add_seed(const zmk_template_Request *req) {
+  struct fuzz_seed *seed = &seeds[seed_count];
+  pb_ostream_t stream = pb_ostream_from_buffer(seed->bytes, PAYLOAD_SIZE);
+  if (!pb_encode(&stream, zmk_template_Request_fields, req)) {
+    LOG_ERR("Failed to encode fuzz seed: %s", PB_GET_ERROR(&stream));
+    return;
+  }
+  seed->size = stream.bytes_written;
+  seed_count++;
+}
+
+static bool encode_seed_batch(pb_ostream_t *stream, const pb_field_t *field,
+                              void *const *arg) {
+  // The sample seed, encoded first
+  for (size_t i = 0; i < BATCH_ENTRIES; i++) {
+    if (!pb_encode_tag_for_field(stream, field) ||
+        !pb_encode_string(stream, seeds[0].bytes, seeds[0].size)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void build_seeds(void) {
+  zmk_template_Request req = zmk_template_Request_init_zero;
+  req.request_id = 7;
+  req.which_request_type = zmk_template_Request_sample_tag;
+  req.request_type.sample.value = -12345;
+  add_seed(&req);
+
+  req = (zmk_template_Request)zmk_template_Request_init_zero;
+  req.which_request_type = zmk_template_Request_batch_tag;
+  req.request_type.batch.requests.funcs.encode = encode_seed_batch;
+  add_seed(&req);
+
+  req = (zmk_template_Request)zmk_template_Request_init_zero;
+  req.which_request_type = zmk_template_Request_sample_stream_tag;
+  req.request_type.sample_stream.count = 16;
+  add_seed(&req);
+
+  req = (zmk_template_Request)zmk_template_Request_init_zero;
+  req.which_request_type = zmk_template_Request_ping_tag;
+  req.request_type.ping.sequence = 1;
+  req.request_type.ping.payload.size =
+      sizeof(req.request_type.ping.payload.bytes);
+  memset(req.request_type.ping.payload.bytes, 0xa5,
+         sizeof(req.request_type.ping.payload.bytes));
+  add_seed(&req);
+
+  req = (zmk_template_Request)zmk_template_Request_init_zero;
+  req.which_request_type = zmk_template_Request_get_state_since_tag;
+  req.request_type.get_state_since.epoch = 1;
+  req.request_type.get_state_since.version = 1;
+  add_seed(&req);
+
+  req = (zmk_template_Request)zmk_template_Request_init_zero;
+  req.which_request_type = zmk_template_Request_read_chunk_tag;
+  req.request_type.read_chunk.length = 64;
+  add_seed(&req);
+}
+
+// Request types whose handlers change module state. read_chunk is kept, as no
+// transfer session can be opened without begin_transfer.
+static bool changes_state(uint32_t tag) {
+  switch (tag) {
+  case zmk_template_Request_begin_transfer_tag:
+  case zmk_template_Request_write_chunk_tag:
+  case zmk_template_Request_end_transfer_tag:
+  case zmk_template_Request_get_stats_tag:
+  case zmk_template_Request_set_state_tag:
+  case zmk_template_Request_commit_tag:
+  case zmk_template_Request_sample_slow_tag:
+  case zmk_template_Request_get_job_result_tag:
+  case zmk_template_Request_set_key_events_tag:
+  case zmk_template_Request_get_usage_stats_tag:
+  case zmk_template_Request_read_logs_tag:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Skips over a length-delimited field and returns where its bytes start in
+// `buf`, which `stream` reads from, or NULL if it runs past the end
+static const uint8_t *skip_string(pb_istream_t *stream, const uint8_t *buf,
+                                  size_t size, uint32_t *len) {
+  const uint8_t *start;
+  if (!pb_decode_varint32(stream, len) || *len > stream->bytes_left) {
+    return NULL;
+  }
+  start = buf + size - stream->bytes_left;
+  return pb_read(stream, NULL, *len) ? start : NULL;
+}
+
+static bool request_changes_state(const uint8_t *buf, size_t size,
+                                  bool is_entry);
+
+static bool batch_changes_state(const uint8_t *buf, size_t size) {
+  pb_istream_t stream = pb_istream_from_buffer(buf, size);
+  pb_wire_type_t wire_type;
+  uint32_t tag;
+  bool eof;
+
+  while (pb_decode_tag(&stream, &wire_type, &tag, &eof)) {
+    if (tag != BATCH_REQUESTS || wire_type != PB_WT_STRING) {
+      if (!pb_skip_field(&stream, wire_type)) {
+        return false;
+      }
+      continue;
+    }
+    uint32_t len;
+    const uint8_t *entry = skip_string(&stream, buf, size, &len);
+    if (entry == NULL) {
+      return false;
+    }
+    // Entries are handled one by one, so a malformed one does not stop the
+    // entries after it
+    if (request_changes_state(entry, len, true)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Whether the handler could run a state-changing request for `buf`, either
+ * the request itself or one of its batch entries. Scanning stops where
+ * decoding fails, as the handler then rejects the request. A batch entry that
+ * is itself a batch is rejected, so it is not scanned further.
+ */
+static bool request_changes_state(const uint8_t *buf, size_t size,
+                                  bool is_entry) {
+  pb_istream_t stream = pb_istream_from_buffer(buf, size);
+  pb_wire_type_t wire_type;
+  uint32_t tag;
+  bool eof;
+
+  while (pb_decode_tag(&stream, &wire_type, &tag, &eof)) {
+    if (changes_state(tag)) {
+      return true;
+    }
+    if (tag != REQUEST_BATCH || wire_type != PB_WT_STRING || is_entry) {
+      if (!pb_skip_field(&stream, wire_type)) {
+        return false;
+      }
+      continue;
+    }
+    uint32_t len;
+    const uint8_t *batch = skip_string(&stream, buf, size, &len);
+    if (batch == NULL) {
+      return false;
+    }
+    if (batch_changes_state(batch, len)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static size_t fill_random(uint8_t *buf) {
+  const size_t size = rng_below(PAYLOAD_SIZE + 1);
+  for (size_t j = 0; j < size; j++) {
+    buf[j] = rng_next();
+  }
+  return size;
+}
+
+static size_t build_random(uint8_t *buf, uint32_t i) {
+  size_t size;
+  do {
+    size = fill_random(buf);
+  } while (request_changes_state(buf, size, false));
+  return size;
+}
+
+// A valid request with a few bytes flipped, replaced, dropped or inserted
+static size_t mutate_seed(uint8_t *buf, uint32_t i) {
+  const struct fuzz_seed *seed = &seeds[i % seed_count];
+  size_t size = seed->size;
+  memcpy(buf, seed->bytes, size);
+
+  const uint32_t mutations = 1 + rng_below(4);
+  for (uint32_t m = 0; m < mutations && size > 0; m++) {
+    const size_t at = rng_below(size);
+    switch (rng_below(4)) {
+    case 0:
+      buf[at] ^= BIT(rng_below(8));
+      break;
+    case 1:
+      buf[at] = rng_next();
+      break;
+    case 2:
+      memmove(&buf[at], &buf[at + 1], size - at - 1);
+      size--;
+      break;
+    default:
+      if (size < PAYLOAD_SIZE) {
+        memmove(&buf[at + 1], &buf[at], size - at);
+        buf[at] = rng_next();
+        size++;
+      }
+      break;
+    }
+  }
+  return size;
+}
+
+static size_t build_mutated(uint8_t *buf, uint32_t i) {
+  size_t size;
+  do {
+    size = mutate_seed(buf, i);
+  } while (request_changes_state(buf, size, false));
+  return size;
+}
+
+// Every prefix of every seed, cutting varints and lengths short
+static size_t build_truncated(uint8_t *buf, uint32_t i) {
+  const struct fuzz_seed *seed = &seeds[i % seed_count];
+  const size_t size = (i / seed_count) % (seed->size + 1);
+  memcpy(buf, seed->bytes, size);
+  return size;
+}
+
+static bool encode_bytes_field(pb_ostream_t *stream, uint32_t field,
+                               const uint8_t *bytes, size_t size) {
+  return pb_encode_tag(stream, PB_WT_STRING, field) &&
+         pb_encode_string(stream, bytes, size);
+}
+
+// Batches nested as deep as the payload allows. Only the outer one is
+// decoded into views; a nested batch is rejected when its entry is decoded.
+static size_t build_nested_batch(uint8_t *buf, uint32_t i) {
+  static uint8_t scratch[2][PAYLOAD_SIZE];
+  size_t size = seeds[0].size;
+  memcpy(scratch[0], seeds[0].bytes, size);
+
+  for (int depth = 0;; depth++) {
+    uint8_t entry[PAYLOAD_SIZE];
+    pb_ostream_t stream = pb_ostream_from_buffer(entry, sizeof(entry));
+    pb_ostream_t wrapped =
+        pb_ostream_from_buffer(scratch[(depth + 1) % 2], PAYLOAD_SIZE);
+    if (!encode_bytes_field(&stream, BATCH_REQUESTS, scratch[depth % 2],
+                            size) ||
+        !encode_bytes_field(&wrapped, REQUEST_BATCH, entry,
+                            stream.bytes_written)) {
+      memcpy(buf, scratch[depth % 2], size);
+      return size;
+    }
+    size = wrapped.bytes_written;
+  }
+}
+
+// Far more batch entries than BatchResponse has slots for
+static size_t build_oversized_batch(uint8_t *buf, uint32_t i) {
+  uint8_t entries[PAYLOAD_SIZE];
+  pb_ostream_t stream = pb_ostream_from_buffer(entries, PAYLOAD_SIZE - 4);
+  while (encode_bytes_field(&stream, BATCH_REQUESTS, NULL, 0)) {
+  }
+
+  pb_ostream_t out = pb_ostream_from_buffer(buf, PAYLOAD_SIZE);
+  encode_bytes_field(&out, REQUEST_BATCH, entries, stream.bytes_written);
+  return out.bytes_written;
+}
+
+// A ping payload over its max_size, and a length past the end of the buffer
+static size_t build_oversized_bytes(uint8_t *buf, uint32_t i) {
+  uint8_t ping[PAYLOAD_SIZE];
+  uint8_t payload[PAYLOAD_SIZE / 2];
+  memset(payload, 0x5a, sizeof(payload));
+
+  pb_ostream_t stream = pb_ostream_from_buffer(ping, sizeof(ping));
+  encode_bytes_field(&stream, PING_PAYLOAD, payload, 1 + i % sizeof(payload));
+
+  pb_ostream_t out = pb_ostream_from_buffer(buf, PAYLOAD_SIZE);
+  encode_bytes_field(&out, REQUEST_PING, ping, stream.bytes_written);
+  if (i % 2) {
+    // Claims more bytes than follow
+    pb_encode_tag(&out, PB_WT_STRING, REQUEST_SAMPLE);
+    pb_encode_varint(&out, PAYLOAD_SIZE * 4);
+  }
+  return out.bytes_written;
+}
+
+// The same scalar over and over as a 10-byte varint, then unknown fields
+static size_t build_long_varints(uint8_t *buf, uint32_t i) {
+  static const uint8_t overlong[] = {0xff, 0xff, 0xff, 0xff, 0xff,
+                                     0xff, 0xff, 0xff, 0xff, 0x01};
+  pb_ostream_t out = pb_ostream_from_buffer(buf, PAYLOAD_SIZE);
+  const uint32_t field = i % 2 ? REQUEST_ID : UNKNOWN_FIELD;
+
+  while (pb_encode_tag(&out, PB_WT_VARINT, field) &&
+         pb_write(&out, overlong, sizeof(overlong))) {
+  }
+  return out.bytes_written;
+}
+
+static const struct fuzz_case cases[] = {
+    {.name = "random", .build = build_random},
+    {.name = "mutated", .build = build_mutated},
+    {.name = "truncated", .build = build_truncated},
+    {.name = "nested_batch", .build = build_nested_batch},
+    {.name = "oversized_batch", .build = build_oversized_batch},
+    {.name = "oversized_bytes", .build = build_oversized_bytes},
+    {.name = "long_varints", .build = build_long_varints},
+};
+
+static zmk_custom_CallRequest call_request;
+
+static uint64_t now_us(void) {
+  return native_rtc_gettime_us(RTC_CLOCK_REALTIME);
+}
+
+static void fuzz_verdict(const char *name, const char *verdict) {
+  LOG_INF("verdict %s: %s", name, verdict);
+}
+
+static void run_case(const struct fuzz_case *fuzz) {
+  uint64_t call_us = 0;
+  uint64_t worst_us = 0;
+  uint32_t worst_iteration = 0;
+  size_t request_bytes = 0;
+  size_t failures = 0;
+
+  for (uint32_t i = 0; i < ITERATIONS; i++) {
+    call_request.payload.size = fuzz->build(call_request.payload.bytes, i);
+    request_bytes += call_request.payload.size;
+
+    zmk_custom_CallResponse call_response = zmk_custom_CallResponse_init_zero;
+
+    const uint64_t t0 = now_us();
+    bool ok = template_rpc_bench_call(&call_request, &call_response.payload);
+    const uint64_t t1 = now_us();
+
+    // The transport streams the response, so only its size is computed
+    pb_ostream_t stream = PB_OSTREAM_SIZING;
+    ok = ok &&
+         pb_encode(&stream, zmk_custom_CallResponse_fields, &call_response);
+
+    if (!ok) {
+      failures++;
+    }
+    call_us += t1 - t0;
+    if (t1 - t0 > worst_us) {
+      worst_us = t1 - t0;
+      worst_iteration = i;
+    }
+  }
+
+  const uint32_t requests_per_sec =
+      (uint64_t)ITERATIONS * USEC_PER_SEC / MAX(call_us, 1);
+  const uint32_t bytes_per_sec =
+      (uint64_t)request_bytes * USEC_PER_SEC / MAX(call_us, 1);
+  LOG_INF("%s: %u req/s, %u B/s decoded, worst %u us at iteration %u",
+          fuzz->name, requests_per_sec, bytes_per_sec, (uint32_t)worst_us,
+          worst_iteration);
+
+  if (failures > 0) {
+    LOG_ERR("%s: %zu of %d calls failed", fuzz->name, failures, ITERATIONS);
+    fuzz_verdict(fuzz->name, "calls failed");
+  } else if (worst_us > MAX_CALL_US) {
+    fuzz_verdict(fuzz->name, "slow call");
+  } else {
+    fuzz_verdict(fuzz->name, "ok");
+  }
+}
+
+static void rpc_fuzz_thread(void *p1, void *p2, void *p3) {
+  build_seeds();
+  if (seed_count != ARRAY_SIZE(seeds)) {
+    fuzz_verdict("seeds", "encode failed");
+    return;
+  }
+  LOG_INF("seed %u, %d iterations per case",
+          CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_FUZZ_SEED, ITERATIONS);
+
+  for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+    run_case(&cases[i]);
+  }
+
+  size_t unused = 0;
+  if (k_thread_stack_space_get(k_current_get(), &unused) != 0) {
+    fuzz_verdict("stack", "unknown");
+    return;
+  }
+  const size_t peak = STACK_SIZE - unused;
+  LOG_INF("stack: peak %zu of %d B", peak, STACK_SIZE);
+  fuzz_verdict("stack", peak > MAX_STACK ? "over budget" : "ok");
+}
+
+K_THREAD_DEFINE(template_rpc_fuzz, STACK_SIZE, rpc_fuzz_thread, NULL, NULL,
+                NULL, K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
@@ -0,0 +1,224 @@
+/**
+ * Template Feature - RPC instrumentation
+ *
+ * Keeps min/max/total cycles per processing phase and a latency histogram for
+ * each request type, and serves them through GetStatsRequest.
+ */
+
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include <zmk/template/rpc.h>
+#include <zmk/template/rpc_stream.h>
+
+#include "notification.h"
+#include "rpc_stats.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#define MAX_TYPES CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_STATS_MAX_TYPES
+#define HISTOGRAM_BUCKETS                                                      \
+  ARRAY_SIZE(((zmk_template_RequestTypeStats *)0)->histogram)
+
+// Exclusive upper bounds of the latency buckets, in microseconds
+static const uint32_t histogram_bounds_us[] = {
+    16, 64, 256, 1000, 4000, 16000, 64000,
+};
+
+BUILD_ASSERT(ARRAY_SIZE(histogram_bounds_us) + 1 == HISTOGRAM_BUCKETS,
+             "Histogram bounds do not match the proto options");
+BUILD_ASSERT(ARRAY_SIZE(histogram_bounds_us) ==
+                 ARRAY_SIZE(((zmk_template_GetStatsResponse *)0)
+                                ->histogram_bounds_us),
+             "Histogram bounds do not match the proto options");
+
+struct phase_stats {
+  uint32_t min;
+  uint32_t max;
+  uint64_t total;
+};
+
+struct type_stats {
+  pb_size_t tag;
+  uint32_t count;
+  uint32_t errors;
+  struct phase_stats decode;
+  struct phase_stats handle;
+  struct phase_stats encode;
+  uint32_t histogram[HISTOGRAM_BUCKETS];
+};
+
+static struct type_stats types[MAX_TYPES];
+static size_t types_len;
+static uint32_t decode_failures;
+static uint32_t error_responses;
+static bool reset_requested;
+
+// Top-level request waiting for its response to be encoded
+static struct {
+  bool active;
+  pb_size_t tag;
+  uint32_t decode;
+  uint32_t handle;
+  uint32_t encode;
+  bool error;
+  pb_callback_t framework_encode;
+} pending;
+
+static struct type_stats *find_or_add(pb_size_t tag) {
+  for (size_t i = 0; i < types_len; i++) {
+    if (types[i].tag == tag) {
+      return &types[i];
+    }
+  }
+  if (types_len == MAX_TYPES) {
+    return NULL;
+  }
+  struct type_stats *entry = &types[types_len++];
+  memset(entry, 0, sizeof(*entry));
+  entry->tag = tag;
+  return entry;
+}
+
+static void phase_add(struct phase_stats *phase, uint32_t cycles, bool first) {
+  phase->min = first ? cycles : MIN(phase->min, cycles);
+  phase->max = MAX(phase->max, cycles);
+  phase->total += cycles;
+}
+
+static size_t histogram_bucket(uint32_t cycles) {
+  uint32_t us = k_cyc_to_us_floor32(cycles);
+  for (size_t i = 0; i < ARRAY_SIZE(histogram_bounds_us); i++) {
+    if (us < histogram_bounds_us[i]) {
+      return i;
+    }
+  }
+  return HISTOGRAM_BUCKETS - 1;
+}
+
+void template_rpc_stats_record(pb_size_t tag, uint32_t decode_cycles,
+                               uint32_t handle_cycles, uint32_t encode_cycles,
+                               bool error) {
+  if (error) {
+    error_responses++;
+  }
+
+  struct type_stats *entry = find_or_add(tag);
+  if (!entry) {
+    LOG_DBG("No stats slot left for request type %d", tag);
+    return;
+  }
+
+  bool first = entry->count == 0;
+  entry->count++;
+  entry->errors += error;
+  phase_add(&entry->decode, decode_cycles, first);
+  phase_add(&entry->handle, handle_cycles, first);
+  phase_add(&entry->encode, encode_cycles, first);
+  entry->histogram[histogram_bucket(decode_cycles + handle_cycles +
+                                    encode_cycles)]++;
+}
+
+void template_rpc_stats_begin(void) {
+  if (pending.active) {
+    pending.active = false;
+    template_rpc_stats_record(pending.tag, pending.decode, pending.handle,
+                              pending.encode, pending.error);
+  }
+  if (reset_requested) {
+    reset_requested = false;
+    types_len = 0;
+    decode_failures = 0;
+    error_responses = 0;
+  }
+}
+
+void template_rpc_stats_decode_failure(void) { decode_failures++; }
+
+// Called for each nanopb pass over the response (sizing, then writing)
+static bool timed_encode(pb_ostream_t *stream, const pb_field_t *field,
+                         void *const *arg) {
+  uint32_t start = k_cycle_get_32();
+  bool ok = pending.framework_encode.funcs.encode(
+      stream, field, &pending.framework_encode.arg);
+  pending.encode += k_cycle_get_32() - start;
+  return ok;
+}
+
+void template_rpc_stats_record_pending(pb_callback_t *encode_response,
+                                       pb_size_t tag, uint32_t decode_cycles,
+                                       uint32_t handle_cycles, bool error) {
+  pending.active = true;
+  pending.tag = tag;
+  pending.decode = decode_cycles;
+  pending.handle = handle_cycles;
+  pending.encode = 0;
+  pending.error = error;
+
+  pending.framework_encode = *encode_response;
+  encode_response->funcs.encode = timed_encode;
+  encode_response->arg = NULL;
+}
+
+static void phase_to_proto(const struct phase_stats *phase,
+                           zmk_template_PhaseStats *out) {
+  out->min_cycles = phase->min;
+  out->max_cycles = phase->max;
+  out->total_cycles = phase->total;
+}
+
+static bool stats_stream_next(size_t index, void *item, void *user_data) {
+  const struct type_stats *entry = &types[index];
+  zmk_template_RequestTypeStats *out = item;
+
+  out->request_type = entry->tag;
+  out->count = entry->count;
+  out->errors = entry->errors;
+  out->has_decode = out->has_handle = out->has_encode = true;
+  phase_to_proto(&entry->decode, &out->decode);
+  phase_to_proto(&entry->handle, &out->handle);
+  phase_to_proto(&entry->encode, &out->encode);
+  out->histogram_count = HISTOGRAM_BUCKETS;
+  memcpy(out->histogram, entry->histogram, sizeof(out->histogram));
+  return true;
+}
+
+static zmk_template_RequestTypeStats stats_stream_item;
+static struct zmk_template_rpc_stream stats_stream = {
+    .item_fields = zmk_template_RequestTypeStats_fields,
+    .item = &stats_stream_item,
+    .item_size = sizeof(stats_stream_item),
+    .next = stats_stream_next,
+};
+
+static int handle_get_stats(const zmk_template_GetStatsRequest *req,
+                            zmk_template_Response *resp) {
+  zmk_template_GetStatsResponse *out =
+      ZMK_TEMPLATE_RPC_RESPONSE(resp, get_stats);
+
+  out->cycles_per_second = sys_clock_hw_cycles_per_sec();
+  out->decode_failures = decode_failures;
+  out->error_responses = error_responses;
+
+  struct template_notification_counters notifications;
+  template_notification_get_counters(&notifications);
+  out->notifications_sent = notifications.sent;
+  out->notifications_coalesced = notifications.coalesced;
+  out->notifications_dropped = notifications.dropped;
+
+  out->histogram_bounds_us_count = ARRAY_SIZE(histogram_bounds_us);
+  memcpy(out->histogram_bounds_us, histogram_bounds_us,
+         sizeof(histogram_bounds_us));
+
+  // The table is read while the response is encoded, so a reset is deferred
+  // to the next request.
+  stats_stream.count = types_len;
+  zmk_template_rpc_stream_attach(&out->types, &stats_stream);
+  reset_requested = req->reset;
+  return 0;
+}
+
+ZMK_TEMPLATE_RPC_HANDLER(get_stats, handle_get_stats);
@@ -0,0 +1,62 @@
+/**
+ * Template Feature - RPC instrumentation
+ *
+ * Hooks used by the subsystem core to time request processing. They compile
+ * to nothing unless CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_STATS is enabled.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pb.h>
+
+#include <zephyr/sys/util.h>
+
+#if IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_STATS)
+
+#include <zephyr/kernel.h>
+
+static inline uint32_t template_rpc_stats_now(void) {
+  return k_cycle_get_32();
+}
+
+/**
+ * Start of a top-level request. Commits the previous request, whose encode
+ * time is only known once the Studio transport has written its response.
+ */
+void template_rpc_stats_begin(void);
+
+void template_rpc_stats_decode_failure(void);
+
+/**
+ * Record a request whose response has already been encoded.
+ */
+void template_rpc_stats_record(pb_size_t tag, uint32_t decode_cycles,
+                               uint32_t handle_cycles, uint32_t encode_cycles,
+                               bool error);
+
+/**
+ * Record the top-level request and time the encoding of its response by
+ * wrapping `encode_response`. Committed by the next template_rpc_stats_begin.
+ */
+void template_rpc_stats_record_pending(pb_callback_t *encode_response,
+                                       pb_size_t tag, uint32_t decode_cycles,
+                                       uint32_t handle_cycles, bool error);
+
+#else
+
+static inline uint32_t template_rpc_stats_now(void) { return 0; }
+static inline void template_rpc_stats_begin(void) {}
+static inline void template_rpc_stats_decode_failure(void) {}
+static inline void template_rpc_stats_record(pb_size_t tag,
+                                             uint32_t decode_cycles,
+                                             uint32_t handle_cycles,
+                                             uint32_t encode_cycles,
+                                             bool error) {}
+static inline void template_rpc_stats_record_pending(
+    pb_callback_t *encode_response, pb_size_t tag, uint32_t decode_cycles,
+    uint32_t handle_cycles, bool error) {}
+
+#endif
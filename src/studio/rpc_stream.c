@@ -0,0 +1,33 @@
+/**
+ * Template Feature - Streamed response fields
+ */
+
+#include <string.h>
+
+#include <pb_encode.h>
+#include <zmk/template/rpc_stream.h>
+
+static bool encode_stream(pb_ostream_t *ostream, const pb_field_t *field,
+                          void *const *arg) {
+  const struct zmk_template_rpc_stream *stream = *arg;
+
+  for (size_t i = 0; i < stream->count; i++) {
+    memset(stream->item, 0, stream->item_size);
+    if (!stream->next(i, stream->item, stream->user_data)) {
+      break;
+    }
+    if (!pb_encode_tag_for_field(ostream, field)) {
+      return false;
+    }
+    if (!pb_encode_submessage(ostream, stream->item_fields, stream->item)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void zmk_template_rpc_stream_attach(pb_callback_t *field,
+                                    struct zmk_template_rpc_stream *stream) {
+  field->funcs.encode = encode_stream;
+  field->arg = stream;
+}
@@ -0,0 +1,32 @@
+/**
+ * Template Feature - Zero-copy request fields
+ */
+
+#include <pb_decode.h>
+#include <zmk/template/rpc_view.h>
+
+static bool decode_view(pb_istream_t *stream, const pb_field_t *field,
+                        void **arg) {
+  struct zmk_template_rpc_views *views = *arg;
+
+  if (views->count == views->capacity) {
+    if (views->capacity != 1) {
+      PB_RETURN_ERROR(stream, "too many entries");
+    }
+    views->count = 0;
+  }
+
+  // Requests are always decoded from memory with pb_istream_from_buffer(),
+  // whose state is the current read position in that buffer.
+  struct zmk_template_rpc_view *view = &views->items[views->count++];
+  view->data = stream->state;
+  view->size = stream->bytes_left;
+  return pb_read(stream, NULL, stream->bytes_left);
+}
+
+void zmk_template_rpc_views_attach(pb_callback_t *field,
+                                   struct zmk_template_rpc_views *views) {
+  views->count = 0;
+  field->funcs.decode = decode_view;
+  field->arg = views;
+}
@@ -0,0 +1,120 @@
+/**
+ * Template Feature - Sample request handlers
+ *
+ * Minimal examples of a plain request, a streamed response and an async
+ * handler.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#include <zmk/template/format.h>
+#include <zmk/template/notification.h>
+#include <zmk/template/rpc.h>
+#include <zmk/template/rpc_stream.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+/**
+ * Handle the SampleRequest and populate the response.
+ */
+static int handle_sample_request(const zmk_template_SampleRequest *req,
+                                 zmk_template_Response *resp) {
+  LOG_DBG("Received sample request with value: %d", req->value);
+
+  zmk_template_SampleResponse *result = ZMK_TEMPLATE_RPC_RESPONSE(resp, sample);
+  result->received = req->value;
+
+  // Create a simple response string based on the request value
+  struct zmk_template_fmt fmt;
+  zmk_template_fmt_init(&fmt, result->value, sizeof(result->value));
+  zmk_template_fmt_str(&fmt, "Hello from firmware! Received: ");
+  zmk_template_fmt_int(&fmt, req->value);
+
+  // Also echo the value out of band to demonstrate notifications
+  zmk_template_Notification notification = {
+      .which_notification_type = zmk_template_Notification_sample_tag,
+      .notification_type.sample.value = req->value,
+  };
+  zmk_template_notify(&notification);
+  return 0;
+}
+
+ZMK_TEMPLATE_RPC_HANDLER(sample, handle_sample_request);
+
+struct sample_stream_state {
+  uint32_t count;
+  int32_t start;
+};
+
+static bool sample_stream_next(size_t index, void *item, void *user_data) {
+  const struct sample_stream_state *state = user_data;
+  zmk_template_SampleRecord *record = item;
+
+  record->index = index;
+  record->value = state->start + (int32_t)index;
+  return true;
+}
+
+// Referenced by the response encode callback after the handler returned
+static struct sample_stream_state sample_stream_state;
+static zmk_template_SampleRecord sample_stream_item;
+static struct zmk_template_rpc_stream sample_stream = {
+    .item_fields = zmk_template_SampleRecord_fields,
+    .item = &sample_stream_item,
+    .item_size = sizeof(sample_stream_item),
+    .next = sample_stream_next,
+    .user_data = &sample_stream_state,
+};
+
+/**
+ * Handle the SampleStreamRequest. Records are generated while the response is
+ * encoded, so only a single record is held in RAM regardless of `count`.
+ */
+static int
+handle_sample_stream_request(const zmk_template_SampleStreamRequest *req,
+                             zmk_template_Response *resp) {
+  LOG_DBG("Received sample stream request for %d records", req->count);
+
+  sample_stream_state.count =
+      MIN(req->count,
+          CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_SAMPLE_STREAM_MAX_RECORDS);
+  sample_stream_state.start = req->start;
+  sample_stream.count = sample_stream_state.count;
+
+  zmk_template_SampleStreamResponse *out =
+      ZMK_TEMPLATE_RPC_RESPONSE(resp, sample_stream);
+  zmk_template_rpc_stream_attach(&out->records, &sample_stream);
+  return 0;
+}
+
+ZMK_TEMPLATE_RPC_HANDLER(sample_stream, handle_sample_stream_request);
+
+// Upper bound so a stray request cannot tie up the async queue for long
+#define SAMPLE_SLOW_MAX_DELAY_MS 10000
+
+/**
+ * Handle the SampleSlowRequest on the async work queue. Blocking here keeps
+ * the Studio RPC thread free for other subsystems.
+ */
+static int handle_sample_slow_request(const zmk_template_SampleSlowRequest *req,
+                                      zmk_template_Response *resp) {
+  const unsigned int delay_ms = MIN(req->delay_ms, SAMPLE_SLOW_MAX_DELAY_MS);
+
+  LOG_DBG("Received slow sample request, sleeping %u ms", delay_ms);
+  k_msleep(delay_ms);
+
+  zmk_template_SampleResponse *result = ZMK_TEMPLATE_RPC_RESPONSE(resp, sample);
+  result->received = req->value;
+
+  struct zmk_template_fmt fmt;
+  zmk_template_fmt_init(&fmt, result->value, sizeof(result->value));
+  zmk_template_fmt_str(&fmt, "Slept ");
+  zmk_template_fmt_uint(&fmt, delay_ms);
+  zmk_template_fmt_str(&fmt, " ms! Received: ");
+  zmk_template_fmt_int(&fmt, req->value);
+  return 0;
+}
+
+ZMK_TEMPLATE_RPC_ASYNC_HANDLER(sample_slow, handle_sample_slow_request);
@@ -0,0 +1,166 @@
+/**
+ * Template Feature - Settings backend
+ *
+ * Persists the module state through Zephyr settings. Changed fields are only
+ * marked dirty; they are written in one batch once the state has been quiet
+ * for CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_SETTINGS_DEBOUNCE_MS, or right
+ * away on a CommitRequest. Dragging a slider in the web UI therefore costs
+ * one flash write per field instead of one per step.
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+
+#include <zmk/template/format.h>
+#include <zmk/template/rpc.h>
+#include <zmk/template/state.h>
+
+#include "state.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#define SETTINGS_SUBTREE "template/state"
+#define DEBOUNCE                                                               \
+  K_MSEC(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_SETTINGS_DEBOUNCE_MS)
+
+struct state_key {
+  const char *name;
+  size_t offset;
+  size_t has_offset;
+  size_t size;
+  bool is_string;
+};
+
+#define STATE_KEY(field, key_name, string)                                     \
+  [field] = {                                                                  \
+      .name = #key_name,                                                       \
+      .offset = offsetof(zmk_template_ModuleState, key_name),                  \
+      .has_offset = offsetof(zmk_template_ModuleState, has_##key_name),        \
+      .size = sizeof(((zmk_template_ModuleState *)0)->key_name),               \
+      .is_string = string,                                                     \
+  }
+
+// Stored under SETTINGS_SUBTREE/<name>. Renaming one drops the saved value.
+static const struct state_key state_keys[TEMPLATE_STATE_FIELD_COUNT] = {
+    STATE_KEY(TEMPLATE_STATE_ENABLED, enabled, false),
+    STATE_KEY(TEMPLATE_STATE_BRIGHTNESS, brightness, false),
+    STATE_KEY(TEMPLATE_STATE_MODE, mode, false),
+    STATE_KEY(TEMPLATE_STATE_LABEL, label, true),
+};
+
+// BIT(template_state_field) of every field changed since the last flush
+static atomic_t dirty;
+
+static int flush_dirty(void) {
+  const uint32_t fields = atomic_clear(&dirty);
+  if (!fields) {
+    return 0;
+  }
+
+  zmk_template_ModuleState current;
+  zmk_template_state_get(&current);
+
+  int saved = 0;
+  uint32_t failed = 0;
+  for (int i = 0; i < TEMPLATE_STATE_FIELD_COUNT; i++) {
+    if (!(fields & BIT(i))) {
+      continue;
+    }
+
+    const struct state_key *key = &state_keys[i];
+    const uint8_t *value = (const uint8_t *)&current + key->offset;
+    size_t len = key->is_string ? strnlen((const char *)value, key->size)
+                                : key->size;
+
+    char path[32];
+    struct zmk_template_fmt fmt;
+    zmk_template_fmt_init(&fmt, path, sizeof(path));
+    zmk_template_fmt_str(&fmt, SETTINGS_SUBTREE "/");
+    zmk_template_fmt_str(&fmt, key->name);
+    int rc = settings_save_one(path, value, len);
+    if (rc != 0) {
+      LOG_ERR("Failed to save %s: %d", path, rc);
+      failed |= BIT(i);
+      continue;
+    }
+    saved++;
+  }
+
+  if (failed) {
+    // Retried with the next flush
+    atomic_or(&dirty, failed);
+    return -EIO;
+  }
+  LOG_DBG("Saved %d state fields", saved);
+  return saved;
+}
+
+static void flush_work_handler(struct k_work *work) { flush_dirty(); }
+
+static K_WORK_DELAYABLE_DEFINE(flush_work, flush_work_handler);
+
+void template_settings_mark_dirty(uint32_t fields) {
+  atomic_or(&dirty, fields);
+  // Restart the delay on every change, so a burst is written once at its end
+  k_work_reschedule(&flush_work, DEBOUNCE);
+}
+
+static int handle_commit(const zmk_template_CommitRequest *req,
+                         zmk_template_Response *resp) {
+  k_work_cancel_delayable(&flush_work);
+
+  int saved = flush_dirty();
+  if (saved < 0) {
+    k_work_reschedule(&flush_work, DEBOUNCE);
+    return saved;
+  }
+
+  ZMK_TEMPLATE_RPC_RESPONSE(resp, commit)->saved = saved;
+  return 0;
+}
+
+ZMK_TEMPLATE_RPC_HANDLER(commit, handle_commit);
+
+// Values read by settings_load(), applied together once loading completes
+static zmk_template_ModuleState loaded;
+
+static int template_settings_set(const char *name, size_t len,
+                                 settings_read_cb read_cb, void *cb_arg) {
+  for (int i = 0; i < TEMPLATE_STATE_FIELD_COUNT; i++) {
+    const struct state_key *key = &state_keys[i];
+    if (!settings_name_steq(name, key->name, NULL)) {
+      continue;
+    }
+
+    if (key->is_string ? len >= key->size : len != key->size) {
+      LOG_WRN("Ignoring %s of unexpected size %zu", key->name, len);
+      return -EINVAL;
+    }
+
+    uint8_t *value = (uint8_t *)&loaded + key->offset;
+    memset(value, 0, key->size);
+    int rc = read_cb(cb_arg, value, len);
+    if (rc < 0) {
+      return rc;
+    }
+    *((bool *)((uint8_t *)&loaded + key->has_offset)) = true;
+    return 0;
+  }
+  return -ENOENT;
+}
+
+static int template_settings_commit(void) {
+  template_state_restore(&loaded);
+  return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(zmk_template_state, SETTINGS_SUBTREE, NULL,
+                               template_settings_set, template_settings_commit,
+                               NULL);
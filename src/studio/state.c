@@ -0,0 +1,196 @@
+/**
+ * Template Feature - Module state
+ *
+ * Each field remembers the state version at which it last changed. A
+ * GetStateSinceRequest is answered with the fields newer than the client's
+ * version, so reconnecting costs a few bytes when little has changed.
+ *
+ * Versions restart at boot, so they are qualified by a random epoch. A
+ * client holding another epoch gets the full state.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/random/random.h>
+#include <zephyr/sys/util.h>
+
+#include <zmk/template/lazy_init.h>
+#include <zmk/template/notification.h>
+#include <zmk/template/rpc.h>
+#include <zmk/template/state.h>
+
+#include "state.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#define MAX_BRIGHTNESS 100
+
+static K_MUTEX_DEFINE(state_lock);
+
+static zmk_template_ModuleState state = {
+    .has_enabled = true,
+    .enabled = true,
+    .has_brightness = true,
+    .brightness = 50,
+    .has_mode = true,
+    .mode = 0,
+    .has_label = true,
+    .label = "Template",
+};
+
+static uint32_t epoch;
+static uint32_t version;
+// Version at which each field last changed
+static uint32_t field_versions[TEMPLATE_STATE_FIELD_COUNT];
+
+static int template_state_init(void) {
+  // 0 is what clients send when they hold no state
+  do {
+    epoch = sys_rand32_get();
+  } while (epoch == 0);
+  return 0;
+}
+
+// The entropy source may take a while to deliver the first random number
+ZMK_TEMPLATE_LAZY_INIT(state_epoch, template_state_init);
+
+void zmk_template_state_get(zmk_template_ModuleState *out) {
+  k_mutex_lock(&state_lock, K_FOREVER);
+  *out = state;
+  k_mutex_unlock(&state_lock);
+}
+
+int zmk_template_state_update(const zmk_template_ModuleState *changes) {
+  // Change notifications carry the epoch
+  ZMK_TEMPLATE_LAZY_INIT_ENSURE(state_epoch);
+
+  if (changes->has_brightness && changes->brightness > MAX_BRIGHTNESS) {
+    return -EINVAL;
+  }
+
+  uint32_t changed = 0;
+
+  k_mutex_lock(&state_lock, K_FOREVER);
+
+  if (changes->has_enabled && changes->enabled != state.enabled) {
+    state.enabled = changes->enabled;
+    changed |= BIT(TEMPLATE_STATE_ENABLED);
+  }
+  if (changes->has_brightness && changes->brightness != state.brightness) {
+    state.brightness = changes->brightness;
+    changed |= BIT(TEMPLATE_STATE_BRIGHTNESS);
+  }
+  if (changes->has_mode && changes->mode != state.mode) {
+    state.mode = changes->mode;
+    changed |= BIT(TEMPLATE_STATE_MODE);
+  }
+  if (changes->has_label && strcmp(changes->label, state.label) != 0) {
+    memcpy(state.label, changes->label, sizeof(state.label));
+    changed |= BIT(TEMPLATE_STATE_LABEL);
+  }
+
+  if (changed) {
+    version++;
+    for (int i = 0; i < TEMPLATE_STATE_FIELD_COUNT; i++) {
+      if (changed & BIT(i)) {
+        field_versions[i] = version;
+      }
+    }
+  }
+
+  const uint32_t new_version = version;
+  k_mutex_unlock(&state_lock);
+
+  if (changed) {
+    template_settings_mark_dirty(changed);
+
+    LOG_DBG("State version %d, changed fields 0x%x", new_version, changed);
+    zmk_template_Notification notification = {
+        .which_notification_type = zmk_template_Notification_state_changed_tag,
+        .notification_type.state_changed = {.epoch = epoch,
+                                            .version = new_version},
+    };
+    zmk_template_notify(&notification);
+  }
+  return 0;
+}
+
+uint32_t zmk_template_state_version(void) {
+  k_mutex_lock(&state_lock, K_FOREVER);
+  const uint32_t current = version;
+  k_mutex_unlock(&state_lock);
+  return current;
+}
+
+void template_state_restore(const zmk_template_ModuleState *values) {
+  k_mutex_lock(&state_lock, K_FOREVER);
+  if (values->has_enabled) {
+    state.enabled = values->enabled;
+  }
+  if (values->has_brightness && values->brightness <= MAX_BRIGHTNESS) {
+    state.brightness = values->brightness;
+  }
+  if (values->has_mode) {
+    state.mode = values->mode;
+  }
+  if (values->has_label) {
+    memcpy(state.label, values->label, sizeof(state.label));
+  }
+  k_mutex_unlock(&state_lock);
+}
+
+/**
+ * Fill `out` with the fields changed after `since` in epoch `client_epoch`,
+ * or with the full state if the client's copy cannot be updated in place.
+ * Called with `state_lock` held.
+ */
+static void fill_state_response(uint32_t client_epoch, uint32_t since,
+                                zmk_template_GetStateResponse *out) {
+  const bool full = client_epoch != epoch || since == 0 || since > version;
+
+  out->epoch = epoch;
+  out->version = version;
+  out->full = full;
+  out->has_state = true;
+  out->state = state;
+
+  // Drop the fields the client already has
+#define CHANGED_SINCE(field) (full || field_versions[field] > since)
+  out->state.has_enabled = CHANGED_SINCE(TEMPLATE_STATE_ENABLED);
+  out->state.has_brightness = CHANGED_SINCE(TEMPLATE_STATE_BRIGHTNESS);
+  out->state.has_mode = CHANGED_SINCE(TEMPLATE_STATE_MODE);
+  out->state.has_label = CHANGED_SINCE(TEMPLATE_STATE_LABEL);
+#undef CHANGED_SINCE
+}
+
+static int handle_get_state_since(const zmk_template_GetStateSinceRequest *req,
+                                  zmk_template_Response *resp) {
+  zmk_template_GetStateResponse *out = ZMK_TEMPLATE_RPC_RESPONSE(resp, state);
+
+  k_mutex_lock(&state_lock, K_FOREVER);
+  fill_state_response(req->epoch, req->version, out);
+  k_mutex_unlock(&state_lock);
+  return 0;
+}
+
+ZMK_TEMPLATE_RPC_HANDLER(get_state_since, handle_get_state_since);
+
+static int handle_set_state(const zmk_template_SetStateRequest *req,
+                            zmk_template_Response *resp) {
+  int rc = zmk_template_state_update(&req->state);
+  if (rc != 0) {
+    return rc;
+  }
+
+  zmk_template_GetStateResponse *out = ZMK_TEMPLATE_RPC_RESPONSE(resp, state);
+
+  k_mutex_lock(&state_lock, K_FOREVER);
+  fill_state_response(req->epoch, req->version, out);
+  k_mutex_unlock(&state_lock);
+  return 0;
+}
+
+ZMK_TEMPLATE_RPC_HANDLER(set_state, handle_set_state);
@@ -0,0 +1,41 @@
+/**
+ * Template Feature - Module state (internal)
+ *
+ * Shared by the state handlers and the settings backend persisting them.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <zephyr/sys/util.h>
+
+#include <zmk/template/custom.pb.h>
+
+enum template_state_field {
+  TEMPLATE_STATE_ENABLED,
+  TEMPLATE_STATE_BRIGHTNESS,
+  TEMPLATE_STATE_MODE,
+  TEMPLATE_STATE_LABEL,
+  TEMPLATE_STATE_FIELD_COUNT,
+};
+
+/**
+ * Apply values loaded from flash. Unlike zmk_template_state_update() this
+ * neither notifies nor marks the fields for saving.
+ */
+void template_state_restore(const zmk_template_ModuleState *values);
+
+#if IS_ENABLED(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_SETTINGS)
+
+/**
+ * Queue the fields in the `BIT(template_state_field)` mask for saving. They
+ * are written together once no change arrived for the debounce delay.
+ */
+void template_settings_mark_dirty(uint32_t fields);
+
+#else
+
+static inline void template_settings_mark_dirty(uint32_t fields) {}
+
+#endif
@@ -0,0 +1,202 @@
+/**
+ * Template Feature - Chunked transfer handlers
+ *
+ * Moves blobs larger than one RPC frame as a sequence of chunk requests.
+ * A single session is open at a time. Chunks carry their own offset, so the
+ * host may pipeline several of them and receive replies in any order.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/util.h>
+
+#include <zmk/template/rpc.h>
+#include <zmk/template/rpc_view.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#define TRANSFER_BUFFER_SIZE                                                   \
+  CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_TRANSFER_BUFFER_SIZE
+
+// Largest chunk returned, bounded by the proto options
+#define TRANSFER_MAX_CHUNK_SIZE                                                \
+  sizeof(((zmk_template_ReadChunkResponse *)0)->data.bytes)
+
+struct transfer_session {
+  bool active;
+  uint32_t id;
+  zmk_template_TransferDirection direction;
+  uint32_t size;
+};
+
+static uint8_t scratch_blob[TRANSFER_BUFFER_SIZE];
+static size_t scratch_blob_len;
+
+static struct transfer_session session;
+static uint32_t last_transfer_id;
+
+// WriteChunkRequest.data, referenced in place in the request payload
+static struct zmk_template_rpc_view write_chunk_data_view;
+static struct zmk_template_rpc_views write_chunk_data = {
+    .items = &write_chunk_data_view,
+    .capacity = 1,
+};
+
+static void prepare_write_chunk(zmk_template_WriteChunkRequest *req) {
+  zmk_template_rpc_views_attach(&req->data, &write_chunk_data);
+}
+
+static int find_session(uint32_t transfer_id,
+                        zmk_template_TransferDirection direction) {
+  if (!session.active || session.id != transfer_id) {
+    LOG_WRN("Unknown transfer id %d", transfer_id);
+    return -ENOENT;
+  }
+  if (session.direction != direction) {
+    LOG_WRN("Transfer %d has the wrong direction", transfer_id);
+    return -EINVAL;
+  }
+  return 0;
+}
+
+static int handle_begin(const zmk_template_BeginTransferRequest *req,
+                        zmk_template_Response *resp) {
+  if (req->resource != zmk_template_TransferResource_TRANSFER_RESOURCE_SCRATCH) {
+    LOG_WRN("Unsupported transfer resource %d", req->resource);
+    return -ENOTSUP;
+  }
+
+  uint32_t size;
+  uint32_t crc = 0;
+  switch (req->direction) {
+  case zmk_template_TransferDirection_TRANSFER_DIRECTION_READ:
+    size = scratch_blob_len;
+    crc = crc32_ieee(scratch_blob, scratch_blob_len);
+    break;
+  case zmk_template_TransferDirection_TRANSFER_DIRECTION_WRITE:
+    if (req->size > TRANSFER_BUFFER_SIZE) {
+      LOG_WRN("Transfer size %d exceeds buffer size %d", req->size,
+              TRANSFER_BUFFER_SIZE);
+      return -EFBIG;
+    }
+    size = req->size;
+    // The blob is invalid until the transfer has been committed
+    scratch_blob_len = 0;
+    break;
+  default:
+    LOG_WRN("Unsupported transfer direction %d", req->direction);
+    return -EINVAL;
+  }
+
+  if (session.active) {
+    LOG_DBG("Transfer %d replaced by a new session", session.id);
+  }
+  session = (struct transfer_session){
+      .active = true,
+      .id = ++last_transfer_id,
+      .direction = req->direction,
+      .size = size,
+  };
+  LOG_DBG("Begin transfer %d, size %d", session.id, size);
+
+  zmk_template_BeginTransferResponse *out =
+      ZMK_TEMPLATE_RPC_RESPONSE(resp, begin_transfer);
+  out->transfer_id = session.id;
+  out->size = size;
+  out->max_chunk_size = TRANSFER_MAX_CHUNK_SIZE;
+  out->crc32 = crc;
+  return 0;
+}
+
+static int handle_read_chunk(const zmk_template_ReadChunkRequest *req,
+                             zmk_template_Response *resp) {
+  int rc = find_session(req->transfer_id,
+                        zmk_template_TransferDirection_TRANSFER_DIRECTION_READ);
+  if (rc != 0) {
+    return rc;
+  }
+  if (req->offset > session.size) {
+    LOG_WRN("Read offset %d out of range", req->offset);
+    return -EINVAL;
+  }
+
+  zmk_template_ReadChunkResponse *out =
+      ZMK_TEMPLATE_RPC_RESPONSE(resp, read_chunk);
+  size_t len =
+      MIN(MIN(req->length, sizeof(out->data.bytes)), session.size - req->offset);
+
+  out->transfer_id = session.id;
+  out->offset = req->offset;
+  memcpy(out->data.bytes, &scratch_blob[req->offset], len);
+  out->data.size = len;
+  out->crc32 = crc32_ieee(out->data.bytes, len);
+  return 0;
+}
+
+static int handle_write_chunk(const zmk_template_WriteChunkRequest *req,
+                              zmk_template_Response *resp) {
+  int rc = find_session(req->transfer_id,
+                        zmk_template_TransferDirection_TRANSFER_DIRECTION_WRITE);
+  if (rc != 0) {
+    return rc;
+  }
+
+  const struct zmk_template_rpc_views *views =
+      zmk_template_rpc_views_get(&req->data);
+  const struct zmk_template_rpc_view data =
+      views->count ? views->items[0] : (struct zmk_template_rpc_view){0};
+
+  if (req->offset > session.size || data.size > session.size - req->offset) {
+    LOG_WRN("Write chunk %d+%zu out of range", req->offset, data.size);
+    return -EINVAL;
+  }
+  if (crc32_ieee(data.data, data.size) != req->crc32) {
+    LOG_WRN("CRC mismatch in write chunk at %d", req->offset);
+    return -EILSEQ;
+  }
+
+  memcpy(&scratch_blob[req->offset], data.data, data.size);
+
+  zmk_template_WriteChunkResponse *out =
+      ZMK_TEMPLATE_RPC_RESPONSE(resp, write_chunk);
+  out->transfer_id = session.id;
+  out->offset = req->offset;
+  out->length = data.size;
+  return 0;
+}
+
+static int handle_end(const zmk_template_EndTransferRequest *req,
+                      zmk_template_Response *resp) {
+  if (!session.active || session.id != req->transfer_id) {
+    LOG_WRN("Unknown transfer id %d", req->transfer_id);
+    return -ENOENT;
+  }
+  session.active = false;
+
+  uint32_t crc = crc32_ieee(scratch_blob, session.size);
+  if (session.direction ==
+      zmk_template_TransferDirection_TRANSFER_DIRECTION_WRITE) {
+    if (crc != req->crc32) {
+      LOG_WRN("CRC mismatch for transfer %d", session.id);
+      return -EILSEQ;
+    }
+    scratch_blob_len = session.size;
+  }
+  LOG_DBG("End transfer %d", session.id);
+
+  zmk_template_EndTransferResponse *out =
+      ZMK_TEMPLATE_RPC_RESPONSE(resp, end_transfer);
+  out->transfer_id = session.id;
+  out->size = session.size;
+  out->crc32 = crc;
+  return 0;
+}
+
+ZMK_TEMPLATE_RPC_HANDLER(begin_transfer, handle_begin);
+ZMK_TEMPLATE_RPC_HANDLER(read_chunk, handle_read_chunk);
+ZMK_TEMPLATE_RPC_HANDLER_WITH_PREPARE(write_chunk, prepare_write_chunk,
+                                      handle_write_chunk);
+ZMK_TEMPLATE_RPC_HANDLER(end_transfer, handle_end);
@@ -0,0 +1,125 @@
+/**
+ * Template Feature - Key usage counters
+ *
+ * Counts presses per key position in a saturating 16-bit table, independent
+ * of whether the web UI is connected. GetUsageStatsRequest returns the table
+ * packed into a single bytes field, which costs 2 bytes per key instead of a
+ * tag and varint per repeated element.
+ *
+ * With CONFIG_SETTINGS the table is saved at most once every
+ * CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_USAGE_SAVE_INTERVAL_MS, and only
+ * after it changed.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+
+#include <zmk/event_manager.h>
+#include <zmk/events/position_state_changed.h>
+#include <zmk/template/rpc.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
+
+#define MAX_POSITIONS CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_USAGE_MAX_POSITIONS
+
+BUILD_ASSERT(sizeof(((zmk_template_UsageStatsResponse *)0)->counts.bytes) ==
+                 2 * MAX_POSITIONS,
+             "UsageStatsResponse.counts must hold every counter");
+
+static uint16_t counts[MAX_POSITIONS];
+static struct k_spinlock lock;
+
+#if IS_ENABLED(CONFIG_SETTINGS)
+
+#define SETTINGS_KEY "template/usage/counts"
+#define SAVE_INTERVAL                                                          \
+  K_MSEC(CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_USAGE_SAVE_INTERVAL_MS)
+
+static void save_work_handler(struct k_work *work) {
+  // Counters are 16-bit, so a press counted meanwhile cannot tear a value;
+  // it is simply saved with the next interval.
+  int rc = settings_save_one(SETTINGS_KEY, counts, sizeof(counts));
+  if (rc != 0) {
+    LOG_ERR("Failed to save usage counters: %d", rc);
+  }
+}
+
+static K_WORK_DELAYABLE_DEFINE(save_work, save_work_handler);
+
+static void counts_changed(void) {
+  // Leaves a scheduled save alone, so changes are written once per interval
+  k_work_schedule(&save_work, SAVE_INTERVAL);
+}
+
+static int usage_settings_set(const char *name, size_t len,
+                              settings_read_cb read_cb, void *cb_arg) {
+  if (!settings_name_steq(name, "counts", NULL)) {
+    return -ENOENT;
+  }
+
+  // A table saved with a different MAX_POSITIONS keeps its common prefix
+  int rc = read_cb(cb_arg, counts, MIN(len, sizeof(counts)));
+  return rc < 0 ? rc : 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(zmk_template_usage, "template/usage", NULL,
+                               usage_settings_set, NULL, NULL);
+
+#else
+
+static void counts_changed(void) {}
+
+#endif
+
+static int usage_listener(const zmk_event_t *eh) {
+  const struct zmk_position_state_changed *ev =
+      as_zmk_position_state_changed(eh);
+  if (!ev || !ev->state || ev->position >= MAX_POSITIONS) {
+    return ZMK_EV_EVENT_BUBBLE;
+  }
+
+  k_spinlock_key_t key = k_spin_lock(&lock);
+  if (counts[ev->position] < UINT16_MAX) {
+    counts[ev->position]++;
+  }
+  k_spin_unlock(&lock, key);
+
+  counts_changed();
+  return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(template_usage, usage_listener);
+ZMK_SUBSCRIPTION(template_usage, zmk_position_state_changed);
+
+static int handle_get_usage_stats(const zmk_template_GetUsageStatsRequest *req,
+                                  zmk_template_Response *resp) {
+  zmk_template_UsageStatsResponse *out =
+      ZMK_TEMPLATE_RPC_RESPONSE(resp, usage_stats);
+  size_t used = 0;
+
+  k_spinlock_key_t key = k_spin_lock(&lock);
+  for (size_t i = 0; i < MAX_POSITIONS; i++) {
+    sys_put_le16(counts[i], &out->counts.bytes[2 * i]);
+    if (counts[i]) {
+      used = i + 1;
+    }
+  }
+  if (req->reset) {
+    memset(counts, 0, sizeof(counts));
+  }
+  k_spin_unlock(&lock, key);
+
+  out->counts.size = 2 * used;
+  if (req->reset) {
+    counts_changed();
+  }
+  return 0;
+}
+
+ZMK_TEMPLATE_RPC_BULK_HANDLER(get_usage_stats, handle_get_usage_stats);
@@ -6,15 +6,46 @@
 import { useContext, useState } from "react";
 import "./App.css";
 import { connect as serial_connect } from "@zmkfirmware/zmk-studio-ts-client/transport/serial";
-import {
-  ZMKConnection,
-  ZMKCustomSubsystem,
-  ZMKAppContext,
-} from "@cormoran/zmk-studio-react-hook";
-import { Request, Response } from "./proto/zmk/template/custom";
+import { ZMKConnection, ZMKAppContext } from "@cormoran/zmk-studio-react-hook";
+import { TransferResource } from "./proto/zmk/template/custom";
+import type {
+  Request,
+  Response,
+  SampleRecord,
+} from "./proto/zmk/template/custom";
+import { templateMethods } from "./methods";
+import { subscribeNotifications } from "./notifications";
+import { callTemplateRPC, SUBSYSTEM_IDENTIFIER } from "./rpc";
+import { KeyHeatmap } from "./KeyHeatmap";
+import { LogPanel } from "./LogPanel";
+import { PingPanel } from "./PingPanel";
+import { StatePanel } from "./StatePanel";
+import { StatsPanel } from "./StatsPanel";
+import { readTransfer, writeTransfer } from "./transfer";
+import { useTelemetry } from "./useTelemetry";
 
-// Custom subsystem identifier - must match firmware registration
-export const SUBSYSTEM_IDENTIFIER = "zmk__template";
+export { SUBSYSTEM_IDENTIFIER } from "./rpc";
+
+// Maximum entries per BatchRequest - must not exceed
+// CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_BATCH_MAX_ENTRIES
+export const MAX_BATCH_SIZE = 8;
+
+// Number of records requested by the stream demo
+const SAMPLE_STREAM_COUNT = 100;
+
+// Size of the blob written and read back by the transfer demo
+const TRANSFER_TEST_SIZE = 1024;
+
+// Time the firmware spends on the async work queue for the slow demo
+const SLOW_REQUEST_DELAY_MS = 2000;
+
+// Human readable text for the records of a SampleStreamResponse
+function describeRecords(records: SampleRecord[]): string {
+  if (records.length === 0) return "Received 0 records";
+  return `Received ${records.length} records (values ${records[0].value}..${
+    records[records.length - 1].value
+  })`;
+}
 
 function App() {
   return (
@@ -57,6 +88,11 @@ function App() {
             </section>
 
             <RPCTestSection />
+            <StatePanel />
+            <KeyHeatmap />
+            <StatsPanel />
+            <LogPanel />
+            <PingPanel />
           </>
         )}
       />
@@ -75,47 +111,144 @@ export function RPCTestSection() {
   const [inputValue, setInputValue] = useState<number>(42);
   const [response, setResponse] = useState<string | null>(null);
   const [isLoading, setIsLoading] = useState(false);
+  const [pendingSamples, setPendingSamples] = useState(0);
+  const [slowPending, setSlowPending] = useState(false);
 
   if (!zmkApp) return null;
 
   const subsystem = zmkApp.findSubsystem(SUBSYSTEM_IDENTIFIER);
 
-  // Send a sample request to the firmware
+  // Encode, send and decode a single request
+  const callRequest = async (request: Request): Promise<Response | null> => {
+    if (!zmkApp.state.connection || !subsystem) return null;
+    return callTemplateRPC(zmkApp.state.connection, subsystem.index, request);
+  };
+
+  // Typed per-request methods generated from custom.proto. Requests answered
+  // by async firmware handlers wait for their job result.
+  const connection = zmkApp.state.connection;
+  const methods = templateMethods(callRequest, {
+    subscribe:
+      connection && subsystem
+        ? (listener) =>
+            subscribeNotifications(connection, subsystem.index, listener)
+        : undefined,
+  });
+
+  // Send a sample request to the firmware. Clicking again before the
+  // response arrives pipelines another request on the same connection.
   const sendSampleRequest = async () => {
-    if (!zmkApp.state.connection || !subsystem) return;
+    setPendingSamples((n) => n + 1);
+
+    try {
+      const sample = await methods.sample({ value: inputValue });
+      console.log("Decoded response:", sample);
+      setResponse(sample.value);
+    } catch (error) {
+      console.error("RPC call failed:", error);
+      setResponse(
+        `Failed: ${error instanceof Error ? error.message : "Unknown error"}`
+      );
+    } finally {
+      setPendingSamples((n) => n - 1);
+    }
+  };
+
+  // Run a request on the firmware's async work queue. Other requests are
+  // still served while it runs.
+  const sendSlowRequest = async () => {
+    setSlowPending(true);
 
+    try {
+      const sample = await methods.sampleSlow({
+        delayMs: SLOW_REQUEST_DELAY_MS,
+        value: inputValue,
+      });
+      setResponse(sample.value);
+    } catch (error) {
+      console.error("Slow RPC call failed:", error);
+      setResponse(
+        `Failed: ${error instanceof Error ? error.message : "Unknown error"}`
+      );
+    } finally {
+      setSlowPending(false);
+    }
+  };
+
+  // Ask the firmware to stream generated records in one response
+  const sendStreamRequest = async () => {
     setIsLoading(true);
     setResponse(null);
 
     try {
-      const service = new ZMKCustomSubsystem(
-        zmkApp.state.connection,
-        subsystem.index
+      const { records } = await methods.sampleStream({
+        count: SAMPLE_STREAM_COUNT,
+        start: inputValue,
+      });
+      setResponse(describeRecords(records));
+    } catch (error) {
+      console.error("Stream RPC call failed:", error);
+      setResponse(
+        `Failed: ${error instanceof Error ? error.message : "Unknown error"}`
       );
+    } finally {
+      setIsLoading(false);
+    }
+  };
 
-      // Create the request using ts-proto
-      const request = Request.create({
-        sample: {
-          value: inputValue,
-        },
-      });
+  // Write a blob through the chunked transfer requests and read it back
+  const sendTransferTest = async () => {
+    setIsLoading(true);
+    setResponse(null);
 
-      // Encode and send the request
-      const payload = Request.encode(request).finish();
-      const responsePayload = await service.callRPC(payload);
+    try {
+      const data = Uint8Array.from({ length: TRANSFER_TEST_SIZE }, () =>
+        Math.floor(Math.random() * 256)
+      );
+      const resource = TransferResource.TRANSFER_RESOURCE_SCRATCH;
+      const started = performance.now();
+      await writeTransfer(callRequest, resource, data);
+      const read = await readTransfer(callRequest, resource);
+      const elapsed = performance.now() - started;
 
-      if (responsePayload) {
-        const resp = Response.decode(responsePayload);
-        console.log("Decoded response:", resp);
+      const matches =
+        read.length === data.length && read.every((b, i) => b === data[i]);
+      setResponse(
+        `${matches ? "Verified" : "Mismatch in"} ${data.length} bytes ` +
+          `written and read back in ${elapsed.toFixed(0)} ms`
+      );
+    } catch (error) {
+      console.error("Transfer failed:", error);
+      setResponse(
+        `Failed: ${error instanceof Error ? error.message : "Unknown error"}`
+      );
+    } finally {
+      setIsLoading(false);
+    }
+  };
+
+  // Send MAX_BATCH_SIZE sample requests in one RPC call
+  const sendBatchRequest = async () => {
+    setIsLoading(true);
+    setResponse(null);
 
-        if (resp.sample) {
-          setResponse(resp.sample.value);
-        } else if (resp.error) {
-          setResponse(`Error: ${resp.error.message}`);
-        }
-      }
+    try {
+      const entries = Array.from({ length: MAX_BATCH_SIZE }, (_, i) => ({
+        method: "sample" as const,
+        request: { value: inputValue + i },
+      }));
+      const results = await methods.batch(entries);
+      setResponse(
+        results
+          .map((result) =>
+            result.status === "fulfilled"
+              ? result.value.value
+              : `Error: ${result.reason.message}`
+          )
+          .join("\n")
+      );
     } catch (error) {
-      console.error("RPC call failed:", error);
+      console.error("Batch RPC call failed:", error);
       setResponse(
         `Failed: ${error instanceof Error ? error.message : "Unknown error"}`
       );
@@ -152,13 +285,42 @@ export function RPCTestSection() {
         />
       </div>
 
-      <button
-        className="btn btn-primary"
-        disabled={isLoading}
-        onClick={sendSampleRequest}
-      >
-        {isLoading ? "⏳ Sending..." : "📤 Send Request"}
-      </button>
+      <div className="button-group">
+        <button className="btn btn-primary" onClick={sendSampleRequest}>
+          📤 Send Request
+          {pendingSamples > 0 && ` (${pendingSamples} in flight)`}
+        </button>
+        <button
+          className="btn btn-secondary"
+          disabled={isLoading}
+          onClick={sendBatchRequest}
+        >
+          📦 Send {MAX_BATCH_SIZE} as Batch
+        </button>
+        <button
+          className="btn btn-secondary"
+          disabled={isLoading}
+          onClick={sendStreamRequest}
+        >
+          📜 Stream {SAMPLE_STREAM_COUNT} Records
+        </button>
+        <button
+          className="btn btn-secondary"
+          disabled={isLoading}
+          onClick={sendTransferTest}
+        >
+          🔁 Transfer {TRANSFER_TEST_SIZE} Bytes
+        </button>
+        <button
+          className="btn btn-secondary"
+          disabled={slowPending}
+          onClick={sendSlowRequest}
+        >
+          {slowPending
+            ? "⏳ Waiting for job..."
+            : `🐢 Slow Request (${SLOW_REQUEST_DELAY_MS / 1000} s)`}
+        </button>
+      </div>
 
       {response && (
         <div className="response-box">
@@ -166,8 +328,23 @@ export function RPCTestSection() {
           <pre>{response}</pre>
         </div>
       )}
+
+      <LastSampleNotification />
     </section>
   );
 }
 
+// Re-renders once per animation frame however fast samples are pushed
+function LastSampleNotification() {
+  const { samples } = useTelemetry();
+  const value = samples.last();
+  if (value === undefined) return null;
+  return (
+    <div className="response-box">
+      <h3>Last Notification:</h3>
+      <pre>Sample value {value}</pre>
+    </div>
+  );
+}
+
 export default App;
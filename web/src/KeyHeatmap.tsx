@@ -0,0 +1,125 @@
+/**
+ * Live key heatmap
+ * Counts key presses streamed as KeyEventBatch notifications, or shows the
+ * totals counted by the firmware. Counts live in the telemetry store and are
+ * drawn to a canvas once per animation frame, so incoming events never
+ * re-render the component. Only the rate line re-renders, once per frame.
+ */
+
+import { useContext, useRef, useState } from "react";
+import { ZMKAppContext } from "@cormoran/zmk-studio-react-hook";
+import { Request } from "./proto/zmk/template/custom";
+import { TemplateRPCError } from "./errors";
+import { callTemplateRPC, SUBSYSTEM_IDENTIFIER } from "./rpc";
+import type { TelemetryStore } from "./telemetry";
+import { fetchUsageCounts } from "./usage";
+import {
+  useTelemetry,
+  useTelemetryCanvas,
+  useTelemetryStore,
+} from "./useTelemetry";
+
+// Positions are drawn as a grid, the keyboard's layout is not known here
+const COLUMNS = 12;
+const CELL_SIZE = 28;
+
+function drawHeatmap(canvas: HTMLCanvasElement, store: TelemetryStore) {
+  const ctx = canvas.getContext("2d");
+  if (!ctx) return;
+
+  const counts = store.keys;
+  const rows = Math.max(1, Math.ceil(counts.counts.length / COLUMNS));
+  canvas.width = COLUMNS * CELL_SIZE;
+  canvas.height = rows * CELL_SIZE;
+
+  const max = Math.max(1, counts.max);
+  for (let position = 0; position < rows * COLUMNS; position++) {
+    const heat = (counts.counts[position] ?? 0) / max;
+    const x = (position % COLUMNS) * CELL_SIZE;
+    const y = Math.floor(position / COLUMNS) * CELL_SIZE;
+    ctx.fillStyle = `rgba(220, 60, 40, ${0.1 + 0.9 * heat})`;
+    ctx.fillRect(x + 1, y + 1, CELL_SIZE - 2, CELL_SIZE - 2);
+  }
+}
+
+function KeyRate() {
+  const store = useTelemetry();
+  return (
+    <p>
+      {store.rate(store.pressTimes)} presses/s, {store.keys.dropped} events
+      lost
+    </p>
+  );
+}
+
+export function KeyHeatmap() {
+  const zmkApp = useContext(ZMKAppContext);
+  const canvasRef = useRef<HTMLCanvasElement>(null);
+  const store = useTelemetryStore();
+  const [streaming, setStreaming] = useState(false);
+  const [error, setError] = useState<string | null>(null);
+
+  useTelemetryCanvas(store, canvasRef, drawHeatmap);
+
+  const subsystem = zmkApp?.findSubsystem(SUBSYSTEM_IDENTIFIER);
+  if (!zmkApp?.state.connection || !subsystem) return null;
+  const connection = zmkApp.state.connection;
+
+  const toggleStreaming = async () => {
+    setError(null);
+    try {
+      const resp = await callTemplateRPC(
+        connection,
+        subsystem.index,
+        Request.create({ setKeyEvents: { enabled: !streaming } })
+      );
+      if (resp?.error) throw new TemplateRPCError(resp.error);
+      setStreaming(resp?.setKeyEvents?.enabled ?? false);
+    } catch (e) {
+      setError(e instanceof Error ? e.message : "Unknown error");
+    }
+  };
+
+  // Show the press counts the firmware collected, also while disconnected
+  const loadTotals = async () => {
+    setError(null);
+    try {
+      store.setKeyCounts(
+        await fetchUsageCounts((request) =>
+          callTemplateRPC(connection, subsystem.index, request)
+        )
+      );
+    } catch (e) {
+      setError(e instanceof Error ? e.message : "Unknown error");
+    }
+  };
+
+  const reset = () => store.clearKeys();
+
+  return (
+    <section className="card">
+      <h2>Key Heatmap</h2>
+
+      {error && (
+        <div className="error-message">
+          <p>🚨 {error}</p>
+        </div>
+      )}
+
+      <div className="button-group">
+        <button className="btn btn-primary" onClick={toggleStreaming}>
+          {streaming ? "⏹ Stop" : "▶️ Start"}
+        </button>
+        <button className="btn btn-secondary" onClick={loadTotals}>
+          Load Device Totals
+        </button>
+        <button className="btn btn-secondary" onClick={reset}>
+          Reset
+        </button>
+      </div>
+
+      {streaming && <KeyRate />}
+      <canvas ref={canvasRef} className="key-heatmap" />
+    </section>
+  );
+}
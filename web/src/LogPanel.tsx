@@ -0,0 +1,98 @@
+/**
+ * Device log panel
+ * Reads the log records captured by the firmware
+ * (CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_LOG_CAPTURE). Without a dictionary
+ * from scripts/log_dictionary.py, messages show their format string address
+ * and raw arguments.
+ */
+
+import { useContext, useState } from "react";
+import { ZMKAppContext } from "@cormoran/zmk-studio-react-hook";
+import { formatLogRecord, readLogs } from "./logs";
+import type { LogDictionary, LogRecord } from "./logs";
+import { callTemplateRPC, SUBSYSTEM_IDENTIFIER } from "./rpc";
+
+export function LogPanel() {
+  const zmkApp = useContext(ZMKAppContext);
+  const [records, setRecords] = useState<LogRecord[]>([]);
+  const [dropped, setDropped] = useState(0);
+  const [dictionary, setDictionary] = useState<LogDictionary>();
+  const [error, setError] = useState<string | null>(null);
+  const [isLoading, setIsLoading] = useState(false);
+
+  const subsystem = zmkApp?.findSubsystem(SUBSYSTEM_IDENTIFIER);
+  if (!zmkApp?.state.connection || !subsystem) return null;
+  const connection = zmkApp.state.connection;
+
+  const refresh = async () => {
+    setIsLoading(true);
+    setError(null);
+    try {
+      const result = await readLogs((request) =>
+        callTemplateRPC(connection, subsystem.index, request)
+      );
+      setRecords((previous) => [...previous, ...result.records]);
+      setDropped((previous) => previous + result.dropped);
+    } catch (e) {
+      setError(`Failed: ${e instanceof Error ? e.message : "Unknown error"}`);
+    } finally {
+      setIsLoading(false);
+    }
+  };
+
+  const loadDictionary = async (file: File | undefined) => {
+    if (!file) return;
+    try {
+      setDictionary(JSON.parse(await file.text()));
+    } catch (e) {
+      setError(`Invalid dictionary: ${e instanceof Error ? e.message : e}`);
+    }
+  };
+
+  const clear = () => {
+    setRecords([]);
+    setDropped(0);
+  };
+
+  return (
+    <section className="card">
+      <h2>Device Logs</h2>
+
+      <div className="button-group">
+        <button
+          className="btn btn-secondary"
+          disabled={isLoading}
+          onClick={refresh}
+        >
+          {isLoading ? "⏳ Reading..." : "📜 Read Logs"}
+        </button>
+        <button className="btn btn-secondary" onClick={clear}>
+          Clear
+        </button>
+        <label>
+          Dictionary{" "}
+          <input
+            type="file"
+            accept=".json"
+            onChange={(e) => loadDictionary(e.target.files?.[0])}
+          />
+        </label>
+      </div>
+
+      {error && (
+        <div className="error-message">
+          <p>🚨 {error}</p>
+        </div>
+      )}
+
+      {dropped > 0 && <p>{dropped} records lost</p>}
+      {records.length > 0 && (
+        <pre className="log-output">
+          {records
+            .map((record) => formatLogRecord(record, dictionary))
+            .join("\n")}
+        </pre>
+      )}
+    </section>
+  );
+}
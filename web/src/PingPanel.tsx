@@ -0,0 +1,178 @@
+/**
+ * Latency probe panel
+ * Runs ping bursts and plots their round-trip distribution. Runs are kept
+ * with a label, so the same keyboard can be compared over serial and BLE.
+ */
+
+import { useContext, useEffect, useRef, useState } from "react";
+import { ZMKAppContext } from "@cormoran/zmk-studio-react-hook";
+import { templateMethods } from "./methods";
+import { pingHistogram, runPings, summarizePings } from "./ping";
+import type { PingRun } from "./ping";
+import { callTemplateRPC, SUBSYSTEM_IDENTIFIER } from "./rpc";
+
+const HISTOGRAM_BUCKETS = 40;
+const HISTOGRAM_HEIGHT = 120;
+const BAR_WIDTH = 8;
+
+interface LabeledRun {
+  label: string;
+  run: PingRun;
+}
+
+function drawHistogram(canvas: HTMLCanvasElement, run: PingRun) {
+  const ctx = canvas.getContext("2d");
+  if (!ctx) return;
+
+  const counts = pingHistogram(run, HISTOGRAM_BUCKETS);
+  const max = Math.max(1, ...counts);
+  canvas.width = HISTOGRAM_BUCKETS * BAR_WIDTH;
+  canvas.height = HISTOGRAM_HEIGHT;
+  ctx.fillStyle = "rgb(60, 120, 220)";
+  counts.forEach((count, i) => {
+    const height = (count / max) * HISTOGRAM_HEIGHT;
+    ctx.fillRect(
+      i * BAR_WIDTH + 1,
+      HISTOGRAM_HEIGHT - height,
+      BAR_WIDTH - 2,
+      height
+    );
+  });
+}
+
+const ms = (value: number) => value.toFixed(1);
+
+export function PingPanel() {
+  const zmkApp = useContext(ZMKAppContext);
+  const canvasRef = useRef<HTMLCanvasElement>(null);
+  const [count, setCount] = useState(100);
+  const [inFlight, setInFlight] = useState(1);
+  const [payloadSize, setPayloadSize] = useState(0);
+  const [label, setLabel] = useState("serial");
+  const [runs, setRuns] = useState<LabeledRun[]>([]);
+  const [error, setError] = useState<string | null>(null);
+  const [isRunning, setIsRunning] = useState(false);
+
+  const latest = runs[runs.length - 1];
+  useEffect(() => {
+    if (latest && canvasRef.current) {
+      drawHistogram(canvasRef.current, latest.run);
+    }
+  }, [latest]);
+
+  const subsystem = zmkApp?.findSubsystem(SUBSYSTEM_IDENTIFIER);
+  if (!zmkApp?.state.connection || !subsystem) return null;
+  const connection = zmkApp.state.connection;
+
+  const run = async () => {
+    setIsRunning(true);
+    setError(null);
+    try {
+      const methods = templateMethods((request) =>
+        callTemplateRPC(connection, subsystem.index, request)
+      );
+      const result = await runPings(methods.ping, {
+        count,
+        inFlight,
+        payloadSize,
+      });
+      setRuns((previous) => [...previous, { label, run: result }]);
+    } catch (e) {
+      setError(`Failed: ${e instanceof Error ? e.message : "Unknown error"}`);
+    } finally {
+      setIsRunning(false);
+    }
+  };
+
+  return (
+    <section className="card">
+      <h2>Latency Probe</h2>
+
+      <div className="button-group">
+        <label>
+          Pings{" "}
+          <input
+            type="number"
+            min={1}
+            value={count}
+            onChange={(e) => setCount(Math.max(1, Number(e.target.value)))}
+          />
+        </label>
+        <label>
+          In flight{" "}
+          <input
+            type="number"
+            min={1}
+            value={inFlight}
+            onChange={(e) => setInFlight(Math.max(1, Number(e.target.value)))}
+          />
+        </label>
+        <label>
+          Payload bytes{" "}
+          <input
+            type="number"
+            min={0}
+            value={payloadSize}
+            onChange={(e) =>
+              setPayloadSize(Math.max(0, Number(e.target.value)))
+            }
+          />
+        </label>
+        <label>
+          Label{" "}
+          <input value={label} onChange={(e) => setLabel(e.target.value)} />
+        </label>
+        <button className="btn btn-primary" disabled={isRunning} onClick={run}>
+          {isRunning ? "⏳ Running..." : "📡 Run"}
+        </button>
+      </div>
+
+      {error && (
+        <div className="error-message">
+          <p>🚨 {error}</p>
+        </div>
+      )}
+
+      {runs.length > 0 && (
+        <>
+          <canvas ref={canvasRef} className="ping-histogram" />
+          <table className="stats-table">
+            <thead>
+              <tr>
+                <th>Label</th>
+                <th>Pings</th>
+                <th>Lost</th>
+                <th>p50 ms</th>
+                <th>p99 ms</th>
+                <th>Max ms</th>
+                <th>Pings/s</th>
+                <th>Payload B/s</th>
+                <th>Device ms</th>
+              </tr>
+            </thead>
+            <tbody>
+              {runs.map(({ label, run }, i) => {
+                const summary = summarizePings(run);
+                return (
+                  <tr key={i}>
+                    <td>{label}</td>
+                    <td>{run.roundTripsMs.length}</td>
+                    <td>{run.lost}</td>
+                    <td>{ms(summary.p50)}</td>
+                    <td>{ms(summary.p99)}</td>
+                    <td>{ms(summary.max)}</td>
+                    <td>{summary.pingsPerSecond.toFixed(0)}</td>
+                    <td>{summary.payloadBytesPerSecond.toFixed(0)}</td>
+                    <td>
+                      {ms(run.deviceElapsedMs)} of {ms(run.elapsedMs)}
+                    </td>
+                  </tr>
+                );
+              })}
+            </tbody>
+          </table>
+        </>
+      )}
+    </section>
+  );
+}
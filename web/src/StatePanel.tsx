@@ -0,0 +1,79 @@
+/**
+ * Module state panel
+ * Shows the firmware's ModuleState and edits it through SetStateRequest.
+ * The firmware saves changes after a short delay; Save Now commits them
+ * immediately.
+ */
+
+import { useContext, useState } from "react";
+import { ZMKAppContext } from "@cormoran/zmk-studio-react-hook";
+import { SUBSYSTEM_IDENTIFIER } from "./rpc";
+import { useTemplateState } from "./useTemplateState";
+
+export function StatePanel() {
+  const zmkApp = useContext(ZMKAppContext);
+  const { state, update, commit, error } = useTemplateState();
+  const [saved, setSaved] = useState<number | null>(null);
+
+  if (!zmkApp?.findSubsystem(SUBSYSTEM_IDENTIFIER)) return null;
+
+  return (
+    <section className="card">
+      <h2>Module State</h2>
+
+      {error && (
+        <div className="error-message">
+          <p>🚨 {error}</p>
+        </div>
+      )}
+
+      {!state ? (
+        <p>⏳ Loading...</p>
+      ) : (
+        <>
+          <div className="input-group">
+            <label htmlFor="state-enabled">Enabled:</label>
+            <input
+              id="state-enabled"
+              type="checkbox"
+              checked={state.enabled ?? false}
+              onChange={(e) => update({ enabled: e.target.checked })}
+            />
+          </div>
+          <div className="input-group">
+            <label htmlFor="state-brightness">Brightness:</label>
+            <input
+              id="state-brightness"
+              type="range"
+              min={0}
+              max={100}
+              value={state.brightness ?? 0}
+              onChange={(e) =>
+                update({ brightness: parseInt(e.target.value) || 0 })
+              }
+            />
+          </div>
+          <div className="input-group">
+            <label htmlFor="state-label">Label:</label>
+            <input
+              id="state-label"
+              type="text"
+              maxLength={31}
+              defaultValue={state.label ?? ""}
+              onBlur={(e) => update({ label: e.target.value })}
+            />
+          </div>
+          <div className="button-group">
+            <button
+              className="btn btn-secondary"
+              onClick={async () => setSaved(await commit())}
+            >
+              💾 Save Now
+            </button>
+            {saved !== null && <span>Saved {saved} fields</span>}
+          </div>
+        </>
+      )}
+    </section>
+  );
+}
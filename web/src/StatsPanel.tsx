@@ -0,0 +1,170 @@
+/**
+ * RPC statistics panel
+ * Shows the per request type timings recorded by the firmware
+ * (CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_STATS) and the live notification
+ * rate from the telemetry store.
+ */
+
+import { useContext, useState } from "react";
+import { ZMKAppContext } from "@cormoran/zmk-studio-react-hook";
+import {
+  GetStatsResponse,
+  PhaseStats,
+  Request,
+} from "./proto/zmk/template/custom";
+import { describeError } from "./errors";
+import {
+  callTemplateRPC,
+  REQUEST_TYPE_NAMES,
+  SUBSYSTEM_IDENTIFIER,
+} from "./rpc";
+import { useTelemetry } from "./useTelemetry";
+
+function averageMicros(
+  phase: PhaseStats | undefined,
+  count: number,
+  cyclesPerSecond: number
+): string {
+  if (!phase || count === 0 || cyclesPerSecond === 0) return "-";
+  return ((phase.totalCycles / count / cyclesPerSecond) * 1e6).toFixed(1);
+}
+
+function bucketLabel(bounds: number[], index: number): string {
+  return index < bounds.length
+    ? `<${bounds[index]}µs`
+    : `≥${bounds[bounds.length - 1]}µs`;
+}
+
+// Re-renders once per animation frame while notifications arrive
+function LiveRates() {
+  const store = useTelemetry();
+  return (
+    <p>
+      Notifications received: {store.rate(store.notificationTimes)}/s, key
+      presses: {store.rate(store.pressTimes)}/s
+    </p>
+  );
+}
+
+export function StatsPanel() {
+  const zmkApp = useContext(ZMKAppContext);
+  const [stats, setStats] = useState<GetStatsResponse | null>(null);
+  const [resetAfterRead, setResetAfterRead] = useState(false);
+  const [error, setError] = useState<string | null>(null);
+  const [isLoading, setIsLoading] = useState(false);
+
+  if (!zmkApp) return null;
+
+  const subsystem = zmkApp.findSubsystem(SUBSYSTEM_IDENTIFIER);
+  if (!subsystem) return null;
+
+  const refresh = async () => {
+    if (!zmkApp.state.connection) return;
+
+    setIsLoading(true);
+    setError(null);
+    try {
+      const resp = await callTemplateRPC(
+        zmkApp.state.connection,
+        subsystem.index,
+        Request.create({ getStats: { reset: resetAfterRead } })
+      );
+      if (resp?.getStats) {
+        setStats(resp.getStats);
+      } else if (resp?.error) {
+        setError(`Error: ${describeError(resp.error)}`);
+      }
+    } catch (e) {
+      setError(`Failed: ${e instanceof Error ? e.message : "Unknown error"}`);
+    } finally {
+      setIsLoading(false);
+    }
+  };
+
+  return (
+    <section className="card">
+      <h2>RPC Stats</h2>
+
+      <div className="button-group">
+        <button
+          className="btn btn-secondary"
+          disabled={isLoading}
+          onClick={refresh}
+        >
+          {isLoading ? "⏳ Loading..." : "📊 Refresh Stats"}
+        </button>
+        <label>
+          <input
+            type="checkbox"
+            checked={resetAfterRead}
+            onChange={(e) => setResetAfterRead(e.target.checked)}
+          />{" "}
+          Reset after read
+        </label>
+      </div>
+
+      {error && (
+        <div className="error-message">
+          <p>🚨 {error}</p>
+        </div>
+      )}
+
+      <LiveRates />
+
+      {stats && (
+        <>
+          <p>
+            Decode failures: {stats.decodeFailures}, error responses:{" "}
+            {stats.errorResponses}
+          </p>
+          <p>
+            Notifications sent: {stats.notificationsSent}, coalesced:{" "}
+            {stats.notificationsCoalesced}, dropped:{" "}
+            {stats.notificationsDropped}
+          </p>
+          <table className="stats-table">
+            <thead>
+              <tr>
+                <th>Request</th>
+                <th>Count</th>
+                <th>Errors</th>
+                <th>Decode µs</th>
+                <th>Handle µs</th>
+                <th>Encode µs</th>
+                <th>Latency</th>
+              </tr>
+            </thead>
+            <tbody>
+              {stats.types.map((t) => (
+                <tr key={t.requestType}>
+                  <td>{REQUEST_TYPE_NAMES[t.requestType] ?? t.requestType}</td>
+                  <td>{t.count}</td>
+                  <td>{t.errors}</td>
+                  <td>
+                    {averageMicros(t.decode, t.count, stats.cyclesPerSecond)}
+                  </td>
+                  <td>
+                    {averageMicros(t.handle, t.count, stats.cyclesPerSecond)}
+                  </td>
+                  <td>
+                    {averageMicros(t.encode, t.count, stats.cyclesPerSecond)}
+                  </td>
+                  <td>
+                    {t.histogram
+                      .map((n, i) =>
+                        n
+                          ? `${bucketLabel(stats.histogramBoundsUs, i)}: ${n}`
+                          : ""
+                      )
+                      .filter(Boolean)
+                      .join(", ")}
+                  </td>
+                </tr>
+              ))}
+            </tbody>
+          </table>
+        </>
+      )}
+    </section>
+  );
+}
@@ -0,0 +1,69 @@
+/**
+ * Response cache for read requests
+ * Answers repeated idempotent reads without a round trip. Entries are keyed
+ * by the encoded request and belong to the module state version they were
+ * read at. Every response carries the firmware's current `stateVersion`,
+ * and StateChangedNotification announces changes made on the device, so a
+ * new version drops all entries.
+ */
+
+import { Compression, Request, Response } from "./proto/zmk/template/custom";
+
+// Reads whose response only depends on the request and the module state
+const CACHEABLE_REQUESTS: (keyof Request)[] = ["getStateSince", "sampleStream"];
+
+const DEFAULT_MAX_ENTRIES = 32;
+
+export class ResponseCache {
+  private readonly maxEntries: number;
+  // In insertion order, so the first entry is the least recently used
+  private readonly entries = new Map<string, Response>();
+  private version = 0;
+
+  constructor(maxEntries = DEFAULT_MAX_ENTRIES) {
+    this.maxEntries = maxEntries;
+  }
+
+  get size(): number {
+    return this.entries.size;
+  }
+
+  // Cache key of `request`, or undefined if its response must not be cached
+  keyOf(request: Request): string | undefined {
+    if (!CACHEABLE_REQUESTS.some((name) => request[name])) return undefined;
+    const bytes = Request.encode({
+      ...request,
+      requestId: 0,
+      acceptCompression: Compression.COMPRESSION_NONE,
+    }).finish();
+    return String.fromCharCode(...bytes);
+  }
+
+  get(key: string): Response | undefined {
+    const response = this.entries.get(key);
+    if (response) {
+      this.entries.delete(key);
+      this.entries.set(key, response);
+    }
+    return response;
+  }
+
+  set(key: string, response: Response) {
+    // An error may not repeat, and a response built before the latest known
+    // change is already stale
+    if (response.error || response.stateVersion !== this.version) return;
+
+    this.entries.delete(key);
+    this.entries.set(key, response);
+    if (this.entries.size > this.maxEntries) {
+      this.entries.delete(this.entries.keys().next().value!);
+    }
+  }
+
+  // Note the firmware's state version, dropping entries of any other one
+  observeVersion(version: number) {
+    if (version === this.version) return;
+    this.version = version;
+    this.entries.clear();
+  }
+}
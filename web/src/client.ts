@@ -0,0 +1,334 @@
+/**
+ * Template subsystem RPC client
+ * Keeps several requests in flight on one connection. Every request carries
+ * a `requestId` that the firmware echoes back, so responses are matched to
+ * their callers even when they arrive out of order.
+ *
+ * With packing enabled, small requests queued within a few milliseconds of
+ * each other share one BatchRequest frame sized to the link MTU, so callers
+ * get batching without building batches themselves.
+ *
+ * Every request accepts compressed responses, which are decompressed before
+ * they reach the caller. With a ResponseCache, repeated reads are answered
+ * locally until the firmware's state version changes.
+ */
+
+import { ZMKCustomSubsystem } from "@cormoran/zmk-studio-react-hook";
+import {
+  Compression,
+  ErrorCode,
+  Request,
+  Response,
+} from "./proto/zmk/template/custom";
+import { ResponseCache } from "./cache";
+import { decompressResponse } from "./compression";
+import { subscribeNotifications } from "./notifications";
+import type { ZMKConnection } from "./rpc";
+
+export type SendFn = (
+  payload: Uint8Array
+) => Promise<Uint8Array | null | undefined>;
+
+export interface PackingOptions {
+  // Encoded request bytes per frame, i.e. the link MTU less transport framing
+  frameBytes: number;
+  // Longest a call waits for others to share its frame
+  maxDelayMs?: number;
+  // Must not exceed CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_BATCH_MAX_ENTRIES
+  maxEntries?: number;
+}
+
+export interface ClientOptions {
+  // Requests sent before waiting for a response. Further calls are queued.
+  maxInFlight?: number;
+  // Pack queued requests into batch frames. Off unless given.
+  packing?: PackingOptions;
+  // Answer cacheable reads from here. Off unless given.
+  cache?: ResponseCache;
+}
+
+const DEFAULT_MAX_IN_FLIGHT = 4;
+const DEFAULT_PACKING_DELAY_MS = 2;
+const DEFAULT_PACKING_ENTRIES = 8;
+
+// BLE ATT MTU of 247 less the Studio RPC and CallRequest framing
+const DEFAULT_FRAME_BYTES = 200;
+
+// Upper bounds of the bytes a batch adds around its entries: the outer
+// request_type and request_id fields, and a tag and length per entry
+const BATCH_OVERHEAD = 10;
+const ENTRY_OVERHEAD = 3;
+
+// Requests whose responses are larger than a batch slot, so packing them
+// would only cost a retry, and pings, which measure a frame of their own
+const UNPACKED_REQUESTS: (keyof Request)[] = [
+  "batch",
+  "sampleStream",
+  "readChunk",
+  "getStats",
+  "getStateSince",
+  "getJobResult",
+  "getUsageStats",
+  "readLogs",
+  "ping",
+];
+
+// Decoded by compression.ts
+const ACCEPT_COMPRESSION = Compression.COMPRESSION_RLE;
+
+// request_id is a uint32 and 0 means "not set"
+const MAX_REQUEST_ID = 0xffffffff;
+
+interface PendingCall {
+  request: Request;
+  resolve: (response: Response | null) => void;
+  reject: (error: unknown) => void;
+  queuedAt: number;
+  // Encoded batch entry, kept once measured for packing
+  encoded?: Uint8Array;
+  // Never packed, e.g. after its response did not fit a batch slot
+  alone?: boolean;
+}
+
+export class TemplateRPCClient {
+  private readonly send: SendFn;
+  private readonly maxInFlight: number;
+  private readonly cache?: ResponseCache;
+  private readonly queue: PendingCall[] = [];
+  // Calls sent to the device, keyed by request ID
+  private readonly pending = new Map<number, PendingCall>();
+  private packing?: Required<PackingOptions>;
+  private packingTimer?: ReturnType<typeof setTimeout>;
+  private inFlight = 0;
+  private lastRequestId = 0;
+
+  constructor(send: SendFn, options: ClientOptions = {}) {
+    this.send = send;
+    this.maxInFlight = Math.max(
+      1,
+      options.maxInFlight ?? DEFAULT_MAX_IN_FLIGHT
+    );
+    this.cache = options.cache;
+    if (options.packing) {
+      this.packing = {
+        maxDelayMs: DEFAULT_PACKING_DELAY_MS,
+        maxEntries: DEFAULT_PACKING_ENTRIES,
+        ...options.packing,
+      };
+    }
+  }
+
+  // Number of requests sent but not answered yet
+  get inFlightCount(): number {
+    return this.inFlight;
+  }
+
+  // Send `request` as soon as a slot is free and resolve with its response
+  async call(request: Request): Promise<Response | null> {
+    const key = this.cache?.keyOf(request);
+    if (key !== undefined) {
+      // Let a notification being dispatched right now, whose listener may be
+      // the caller, invalidate the cache first
+      await Promise.resolve();
+      const cached = this.cache!.get(key);
+      if (cached) return cached;
+    }
+
+    const response = await new Promise<Response | null>((resolve, reject) => {
+      this.queue.push({ request, resolve, reject, queuedAt: Date.now() });
+      this.pump();
+    });
+    if (response && key !== undefined) this.cache!.set(key, response);
+    return response;
+  }
+
+  // The firmware's state changed, e.g. announced by a notification
+  observeStateVersion(version: number) {
+    this.cache?.observeVersion(version);
+  }
+
+  private nextRequestId(): number {
+    do {
+      this.lastRequestId =
+        this.lastRequestId >= MAX_REQUEST_ID ? 1 : this.lastRequestId + 1;
+    } while (this.pending.has(this.lastRequestId));
+    return this.lastRequestId;
+  }
+
+  private pump() {
+    while (this.inFlight < this.maxInFlight && this.queue.length > 0) {
+      const count = this.nextFrameSize();
+      if (count === 0) {
+        this.armPackingTimer();
+        return;
+      }
+      const calls = this.queue.splice(0, count);
+      this.start(calls.length === 1 ? calls[0] : this.packFrame(calls));
+    }
+  }
+
+  private start(call: PendingCall) {
+    const requestId = this.nextRequestId();
+    this.pending.set(requestId, call);
+    this.inFlight++;
+    this.dispatch(requestId, call.request);
+  }
+
+  private packable(call: PendingCall): boolean {
+    return !call.alone && !UNPACKED_REQUESTS.some((key) => call.request[key]);
+  }
+
+  // Number of queued calls that make up the next frame, or 0 to wait for
+  // more calls to fill it
+  private nextFrameSize(): number {
+    const packing = this.packing;
+    if (!packing) return 1;
+
+    let bytes = BATCH_OVERHEAD;
+    let count = 0;
+    for (const call of this.queue) {
+      if (!this.packable(call)) break;
+      // The frame carries the request ID, entries do not need their own
+      call.encoded ??= Request.encode({
+        ...call.request,
+        requestId: 0,
+        acceptCompression: ACCEPT_COMPRESSION,
+      }).finish();
+      const size = call.encoded.length + ENTRY_OVERHEAD;
+      if (count > 0 && bytes + size > packing.frameBytes) return count;
+      bytes += size;
+      count++;
+      if (count >= packing.maxEntries || bytes >= packing.frameBytes) {
+        return count;
+      }
+    }
+
+    // Calls that cannot be packed go out alone and end the frame before them
+    if (count === 0 || count < this.queue.length) return Math.max(count, 1);
+    const waited = Date.now() - this.queue[0].queuedAt;
+    return waited >= packing.maxDelayMs ? count : 0;
+  }
+
+  private armPackingTimer() {
+    if (this.packingTimer !== undefined || !this.packing) return;
+    const deadline = this.queue[0].queuedAt + this.packing.maxDelayMs;
+    this.packingTimer = setTimeout(() => {
+      this.packingTimer = undefined;
+      this.pump();
+    }, Math.max(0, deadline - Date.now()));
+  }
+
+  // A call that sends `calls` as one BatchRequest and hands each its entry
+  private packFrame(calls: PendingCall[]): PendingCall {
+    return {
+      request: Request.create({
+        batch: { requests: calls.map((call) => call.encoded!) },
+      }),
+      resolve: (response) => this.unpackFrame(calls, response),
+      reject: (error) => calls.forEach((call) => call.reject(error)),
+      queuedAt: Date.now(),
+    };
+  }
+
+  private unpackFrame(calls: PendingCall[], response: Response | null) {
+    if (response?.error?.code === ErrorCode.ERROR_CODE_UNSUPPORTED) {
+      // Firmware built without batch support
+      this.packing = undefined;
+    }
+
+    const entries = response?.batch?.responses ?? [];
+    const retries: PendingCall[] = [];
+    calls.forEach((call, i) => {
+      if (i >= entries.length) {
+        retries.push({ ...call, alone: true });
+        return;
+      }
+      let entry: Response;
+      try {
+        entry = decompressResponse(Response.decode(entries[i]));
+      } catch (error) {
+        call.reject(error);
+        return;
+      }
+      // Entries are answered at the state version of the whole frame
+      entry.stateVersion ||= response!.stateVersion;
+      if (entry.error?.code === ErrorCode.ERROR_CODE_RESPONSE_TOO_LARGE) {
+        retries.push({ ...call, alone: true });
+      } else {
+        call.resolve(entry);
+      }
+    });
+    // Sent by the pump that follows every settled frame
+    this.queue.unshift(...retries);
+  }
+
+  private async dispatch(requestId: number, request: Request) {
+    try {
+      const payload = Request.encode({
+        ...request,
+        requestId,
+        acceptCompression: ACCEPT_COMPRESSION,
+      }).finish();
+      const responsePayload = await this.send(payload);
+      if (!responsePayload) {
+        this.settle(requestId, (call) => call.resolve(null));
+        return;
+      }
+      const response = decompressResponse(Response.decode(responsePayload));
+      this.observeStateVersion(response.stateVersion);
+      // Firmware without request IDs answers with 0
+      const matchedId =
+        response.requestId && this.pending.has(response.requestId)
+          ? response.requestId
+          : requestId;
+      this.settle(matchedId, (call) => call.resolve(response));
+    } catch (error) {
+      this.settle(requestId, (call) => call.reject(error));
+    } finally {
+      this.inFlight--;
+      this.pump();
+    }
+  }
+
+  private settle(requestId: number, action: (call: PendingCall) => void) {
+    const call = this.pending.get(requestId);
+    if (!call) return;
+    this.pending.delete(requestId);
+    action(call);
+  }
+}
+
+// One client per connection and subsystem, so the subsystem instance and
+// request IDs are shared by every caller
+const clients = new WeakMap<object, Map<number, TemplateRPCClient>>();
+
+export function getTemplateClient(
+  connection: ZMKConnection,
+  subsystemIndex: number
+): TemplateRPCClient {
+  let bySubsystem = clients.get(connection);
+  if (!bySubsystem) {
+    bySubsystem = new Map();
+    clients.set(connection, bySubsystem);
+  }
+
+  let client = bySubsystem.get(subsystemIndex);
+  if (!client) {
+    const service = new ZMKCustomSubsystem(connection, subsystemIndex);
+    const created = new TemplateRPCClient(
+      (payload) => service.callRPC(payload),
+      {
+        packing: { frameBytes: DEFAULT_FRAME_BYTES },
+        cache: new ResponseCache(),
+      }
+    );
+    subscribeNotifications(connection, subsystemIndex, (notification) => {
+      if (notification.stateChanged) {
+        created.observeStateVersion(notification.stateChanged.version);
+      }
+    });
+    client = created;
+    bySubsystem.set(subsystemIndex, client);
+  }
+  return client;
+}
@@ -0,0 +1,68 @@
+/**
+ * Response decompression
+ * The firmware run-length encodes the bulk bytes field of a response when
+ * the request accepts it. decompressResponse() restores the field, so code
+ * past the client only ever sees plain responses.
+ */
+
+import { Compression, Response } from "./proto/zmk/template/custom";
+
+// Header bytes below RLE_RUN_FLAG start a literal, the others a run
+const RLE_RUN_FLAG = 0x80;
+const RLE_MIN_RUN = 3;
+
+// Decode COMPRESSION_RLE data, see the Compression enum in custom.proto
+export function decodeRLE(data: Uint8Array): Uint8Array {
+  const out: number[] = [];
+  let i = 0;
+  while (i < data.length) {
+    const header = data[i++];
+    if (header < RLE_RUN_FLAG) {
+      const end = i + header + 1;
+      if (end > data.length) throw new Error("Truncated RLE literal");
+      for (; i < end; i++) out.push(data[i]);
+    } else {
+      if (i >= data.length) throw new Error("Truncated RLE run");
+      const run = header - RLE_RUN_FLAG + RLE_MIN_RUN;
+      const value = data[i++];
+      for (let n = 0; n < run; n++) out.push(value);
+    }
+  }
+  return Uint8Array.from(out);
+}
+
+function decode(compression: Compression, data: Uint8Array): Uint8Array {
+  switch (compression) {
+    case Compression.COMPRESSION_NONE:
+      return data;
+    case Compression.COMPRESSION_RLE:
+      return decodeRLE(data);
+    default:
+      throw new Error(`Unsupported response compression ${compression}`);
+  }
+}
+
+// `response` with its bulk field decompressed
+export function decompressResponse(response: Response): Response {
+  const { compression } = response;
+  if (compression === Compression.COMPRESSION_NONE) return response;
+
+  const plain = { ...response, compression: Compression.COMPRESSION_NONE };
+  if (response.usageStats) {
+    plain.usageStats = {
+      ...response.usageStats,
+      counts: decode(compression, response.usageStats.counts),
+    };
+  } else if (response.readChunk) {
+    plain.readChunk = {
+      ...response.readChunk,
+      data: decode(compression, response.readChunk.data),
+    };
+  } else if (response.readLogs) {
+    plain.readLogs = {
+      ...response.readLogs,
+      records: decode(compression, response.readLogs.records),
+    };
+  }
+  return plain;
+}
@@ -0,0 +1,60 @@
+/**
+ * Error response text
+ * The firmware reports failures as an ErrorCode and the errno of the failed
+ * handler, and only sends a message in debug builds. Text for both lives here.
+ */
+
+import { ErrorCode, ErrorResponse } from "./proto/zmk/template/custom";
+
+const ERROR_CODE_TEXT: Partial<Record<ErrorCode, string>> = {
+  [ErrorCode.ERROR_CODE_DECODE_FAILED]: "Failed to decode request",
+  [ErrorCode.ERROR_CODE_UNSUPPORTED]: "Request not supported by firmware",
+  [ErrorCode.ERROR_CODE_HANDLER_FAILED]: "Failed to process request",
+  [ErrorCode.ERROR_CODE_INVALID_ARGUMENT]: "Invalid argument",
+  [ErrorCode.ERROR_CODE_NOT_FOUND]: "Not found",
+  [ErrorCode.ERROR_CODE_BUSY]: "Device busy, try again",
+  [ErrorCode.ERROR_CODE_IO]: "I/O error",
+  [ErrorCode.ERROR_CODE_RESPONSE_TOO_LARGE]: "Response too large",
+};
+
+// Zephyr errno values that handlers commonly return
+const ERRNO_NAMES: Record<number, string> = {
+  1: "EPERM",
+  2: "ENOENT",
+  5: "EIO",
+  11: "EAGAIN",
+  12: "ENOMEM",
+  16: "EBUSY",
+  22: "EINVAL",
+  28: "ENOSPC",
+  116: "ETIMEDOUT",
+  134: "ENOTSUP",
+};
+
+export function describeError(error: ErrorResponse): string {
+  // Firmware older than error codes only sends a message
+  if (error.code === ErrorCode.ERROR_CODE_UNSPECIFIED && error.message) {
+    return error.message;
+  }
+  let text = ERROR_CODE_TEXT[error.code] ?? `Error code ${error.code}`;
+  if (error.errnoValue) {
+    const errno = -error.errnoValue;
+    text += ` (${ERRNO_NAMES[errno] ?? `errno ${errno}`})`;
+  }
+  // Debug firmware sends its own description as well
+  if (error.message) text += `: ${error.message}`;
+  return text;
+}
+
+// Thrown by helpers that turn an ErrorResponse into an exception
+export class TemplateRPCError extends Error {
+  readonly code: ErrorCode;
+  readonly errnoValue: number;
+
+  constructor(error: ErrorResponse) {
+    super(describeError(error));
+    this.name = "TemplateRPCError";
+    this.code = error.code;
+    this.errnoValue = error.errnoValue;
+  }
+}
@@ -0,0 +1,91 @@
+/**
+ * Async job results
+ * Requests served by async firmware handlers are answered with a
+ * PendingResponse. The real response arrives later as a JobResult
+ * notification; polling with GetJobResultRequest covers a missed one, and
+ * one that was too large to carry the response.
+ */
+
+import {
+  JobResult,
+  Notification,
+  Request,
+  Response,
+} from "./proto/zmk/template/custom";
+import { decompressResponse } from "./compression";
+import { TemplateRPCError } from "./errors";
+import type { NotificationListener } from "./notifications";
+import type { CallFn } from "./transfer";
+
+export type SubscribeFn = (listener: NotificationListener) => () => void;
+
+export interface JobOptions {
+  pollIntervalMs?: number;
+  timeoutMs?: number;
+}
+
+const DEFAULT_POLL_INTERVAL_MS = 1000;
+const DEFAULT_TIMEOUT_MS = 30000;
+
+// Resolve with the final response of `response`, waiting for its job if it
+// is a PendingResponse
+export function awaitJobResult(
+  call: CallFn,
+  subscribe: SubscribeFn,
+  response: Response,
+  options: JobOptions = {}
+): Promise<Response> {
+  if (!response.pending) return Promise.resolve(response);
+  const { jobId } = response.pending;
+
+  return new Promise((resolve, reject) => {
+    const cleanup = () => {
+      clearInterval(poll);
+      clearTimeout(timeout);
+      unsubscribe();
+    };
+    const succeed = (result: JobResult) => {
+      cleanup();
+      try {
+        resolve(decompressResponse(Response.decode(result.response)));
+      } catch (error) {
+        reject(error);
+      }
+    };
+    const fail = (error: unknown) => {
+      cleanup();
+      reject(error);
+    };
+
+    const fetchResult = async () => {
+      try {
+        const resp = await call(Request.create({ getJobResult: { jobId } }));
+        if (resp?.error) {
+          fail(new TemplateRPCError(resp.error));
+        } else if (resp?.jobResult?.done) {
+          succeed(resp.jobResult);
+        }
+      } catch (error) {
+        fail(error);
+      }
+    };
+
+    const unsubscribe = subscribe((notification: Notification) => {
+      const result = notification.jobResult;
+      if (result?.jobId !== jobId || !result.done) return;
+      // The firmware leaves out responses too large for a notification
+      if (result.response.length > 0) succeed(result);
+      else void fetchResult();
+    });
+
+    const poll = setInterval(
+      fetchResult,
+      options.pollIntervalMs ?? DEFAULT_POLL_INTERVAL_MS
+    );
+
+    const timeout = setTimeout(
+      () => fail(new Error(`Job ${jobId} timed out`)),
+      options.timeoutMs ?? DEFAULT_TIMEOUT_MS
+    );
+  });
+}
@@ -0,0 +1,78 @@
+/**
+ * Key event stream decoding
+ * Unpacks KeyEventBatch notifications and keeps per-position press counts
+ * for the heatmap outside of React state.
+ */
+
+import { KeyEventBatch } from "./proto/zmk/template/custom";
+
+export interface KeyEvent {
+  position: number;
+  pressed: boolean;
+  // Firmware uptime in milliseconds
+  timeMs: number;
+}
+
+function readVarint(bytes: Uint8Array, offset: number): [number, number] {
+  let value = 0;
+  let shift = 0;
+  for (;;) {
+    if (offset >= bytes.length) throw new Error("Truncated key event batch");
+    const byte = bytes[offset++];
+    value += (byte & 0x7f) * 2 ** shift;
+    if (!(byte & 0x80)) return [value, offset];
+    shift += 7;
+  }
+}
+
+export function decodeKeyEvents(batch: KeyEventBatch): KeyEvent[] {
+  const events: KeyEvent[] = [];
+  let timeMs = batch.startMs;
+  let offset = 0;
+  while (offset < batch.events.length) {
+    let key: number;
+    let deltaMs: number;
+    [key, offset] = readVarint(batch.events, offset);
+    [deltaMs, offset] = readVarint(batch.events, offset);
+    timeMs += deltaMs;
+    events.push({
+      position: Math.floor(key / 2),
+      pressed: key % 2 === 1,
+      timeMs,
+    });
+  }
+  return events;
+}
+
+// Press counts by key position, updated in place as batches arrive
+export class KeyPressCounts {
+  readonly counts: number[] = [];
+  dropped = 0;
+
+  // Count the presses of `batch` and return its events
+  add(batch: KeyEventBatch): KeyEvent[] {
+    const events = decodeKeyEvents(batch);
+    for (const event of events) {
+      if (event.pressed) {
+        this.counts[event.position] = (this.counts[event.position] ?? 0) + 1;
+      }
+    }
+    this.dropped += batch.dropped;
+    return events;
+  }
+
+  // Replace the counts, e.g. with the totals kept by the firmware
+  set(counts: number[]) {
+    this.counts.splice(0, this.counts.length, ...counts);
+  }
+
+  clear() {
+    this.counts.length = 0;
+    this.dropped = 0;
+  }
+
+  // Holes of the sparse array are skipped
+  get max(): number {
+    return this.counts.reduce((max, count) => Math.max(max, count), 0);
+  }
+}
@@ -0,0 +1,223 @@
+/**
+ * Captured firmware logs
+ * Decodes the records of ReadLogsResponse
+ * (CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_LOG_CAPTURE). The firmware keeps
+ * the cbprintf package of every message, so format strings and constant
+ * string arguments are only known by their address. A LogDictionary made
+ * from the firmware ELF by scripts/log_dictionary.py turns them into text.
+ */
+
+import { templateMethods } from "./methods";
+import type { CallFn } from "./transfer";
+
+export interface LogRecord {
+  timestampMs: number;
+  sourceId: number;
+  level: number;
+  // Address of the format string in the firmware image
+  format: number;
+  // 32-bit argument words that follow the format string
+  args: number[];
+  // Strings copied into the package, keyed by the index of their argument
+  // word in `args`
+  strings: Map<number, string>;
+  // Arguments are tagged with their type, so `args` does not follow the
+  // format string
+  argsTagged: boolean;
+}
+
+// How the firmware builds its packages, from ReadLogsResponse
+export interface PackageLayout {
+  // Header words before the format string address
+  headerWords: number;
+  argsTagged: boolean;
+}
+
+const DEFAULT_LAYOUT: PackageLayout = { headerWords: 1, argsTagged: false };
+
+export interface LogDictionary {
+  // NUL-terminated strings of the firmware image, keyed by address
+  strings: Record<number, string>;
+  // Log module names, keyed by source ID
+  sources: Record<number, string>;
+}
+
+// uint32 timestamp, uint16 source ID, uint8 level, uint8 package length
+const RECORD_HEADER_SIZE = 8;
+
+// Drain at most this many responses per read, the device may keep logging
+const MAX_READS = 32;
+
+const LEVEL_NAMES: Record<number, string> = {
+  1: "err",
+  2: "wrn",
+  3: "inf",
+  4: "dbg",
+};
+
+function readCString(bytes: Uint8Array, offset: number): [string, number] {
+  let end = offset;
+  while (end < bytes.length && bytes[end] !== 0) end++;
+  const text = new TextDecoder().decode(bytes.subarray(offset, end));
+  return [text, end + 1];
+}
+
+// Parse a cbprintf package of a 32-bit target: the header, whose first word
+// holds the length in words, appended string count and the read-only and
+// read-write string position counts, then the format string address and
+// argument words, then the position lists and each appended string after its
+// word position in the package.
+function decodePackage(
+  data: Uint8Array,
+  layout: PackageLayout
+): Pick<LogRecord, "format" | "args" | "strings" | "argsTagged"> {
+  const view = new DataView(data.buffer, data.byteOffset, data.byteLength);
+  const words = Math.min(data[0] ?? 0, data.length >> 2);
+  const strCount = data[1] ?? 0;
+  const formatWord = layout.headerWords;
+  const format = words > formatWord ? view.getUint32(formatWord * 4, true) : 0;
+
+  const args: number[] = [];
+  for (let word = formatWord + 1; word < words; word++) {
+    args.push(view.getUint32(word * 4, true));
+  }
+
+  const strings = new Map<number, string>();
+  let offset = words * 4 + (data[2] ?? 0) + (data[3] ?? 0);
+  for (let i = 0; i < strCount && offset < data.length; i++) {
+    const position = data[offset];
+    const [text, next] = readCString(data, offset + 1);
+    strings.set(position - formatWord - 1, text);
+    offset = next;
+  }
+  return { format, args, strings, argsTagged: layout.argsTagged };
+}
+
+// Split ReadLogsResponse.records into records
+export function decodeLogRecords(
+  records: Uint8Array,
+  layout: PackageLayout = DEFAULT_LAYOUT
+): LogRecord[] {
+  const view = new DataView(
+    records.buffer,
+    records.byteOffset,
+    records.byteLength
+  );
+  const decoded: LogRecord[] = [];
+  let offset = 0;
+  while (offset + RECORD_HEADER_SIZE <= records.length) {
+    const length = records[offset + 7];
+    const end = offset + RECORD_HEADER_SIZE + length;
+    if (end > records.length) throw new Error("Truncated log record");
+    decoded.push({
+      timestampMs: view.getUint32(offset, true),
+      sourceId: view.getUint16(offset + 4, true),
+      level: records[offset + 6],
+      ...decodePackage(
+        records.subarray(offset + RECORD_HEADER_SIZE, end),
+        layout
+      ),
+    });
+    offset = end;
+  }
+  return decoded;
+}
+
+const hex = (value: number) => `0x${value.toString(16).padStart(8, "0")}`;
+
+// printf-style conversion. Width and zero padding are honoured, other flags
+// and the precision are ignored.
+const CONVERSION = /%([-+ #0]*)(\d*)(?:\.\d+)?([hljzt]*)([diouxXcsp%])/g;
+
+// Index of the first argument word of each conversion of `format`.
+// 64-bit arguments take two words, every other one a single word.
+function argumentWords(format: string): number[] {
+  const words: number[] = [];
+  let word = 0;
+  for (const [, , , size, conversion] of format.matchAll(CONVERSION)) {
+    if (conversion === "%") continue;
+    words.push(word);
+    word += size === "ll" ? 2 : 1;
+  }
+  return words;
+}
+
+function formatMessage(record: LogRecord, dictionary?: LogDictionary): string {
+  const format = dictionary?.strings[record.format];
+  if (format === undefined || record.argsTagged) {
+    const args = record.args.map(hex).join(" ");
+    return `<format ${hex(record.format)}>${args ? ` ${args}` : ""}`;
+  }
+
+  const words = argumentWords(format);
+  let conversionIndex = 0;
+  return format.replace(CONVERSION, (_, flags, width, size, conversion) => {
+    if (conversion === "%") return "%";
+    const word = words[conversionIndex++];
+    // Only the low word of a 64-bit argument is shown
+    const value = (record.args[word] ?? 0) >>> 0;
+
+    let text: string;
+    switch (conversion) {
+      case "d":
+      case "i":
+        text = String(value | 0);
+        break;
+      case "x":
+      case "X":
+        text = value.toString(16);
+        if (conversion === "X") text = text.toUpperCase();
+        break;
+      case "o":
+        text = value.toString(8);
+        break;
+      case "c":
+        text = String.fromCharCode(value & 0xff);
+        break;
+      case "s":
+        text =
+          record.strings.get(word) ??
+          dictionary?.strings[value] ??
+          `<string ${hex(value)}>`;
+        break;
+      case "p":
+        text = hex(value);
+        break;
+      default:
+        text = String(value);
+    }
+    const padding = flags.includes("0") && conversion !== "s" ? "0" : " ";
+    return text.padStart(Number(width) || 0, padding);
+  });
+}
+
+// One line per record, like Zephyr's text log output
+export function formatLogRecord(
+  record: LogRecord,
+  dictionary?: LogDictionary
+): string {
+  const time = (record.timestampMs / 1000).toFixed(3).padStart(9);
+  const level = LEVEL_NAMES[record.level] ?? `level ${record.level}`;
+  const source =
+    dictionary?.sources[record.sourceId] ?? `source ${record.sourceId}`;
+  return `[${time}] <${level}> ${source}: ${formatMessage(record, dictionary)}`;
+}
+
+// Drain the captured records, oldest first
+export async function readLogs(
+  call: CallFn
+): Promise<{ records: LogRecord[]; dropped: number }> {
+  const records: LogRecord[] = [];
+  let dropped = 0;
+  const pages = templateMethods(call).stream("readLogs", {}, MAX_READS);
+  for await (const page of pages) {
+    const layout: PackageLayout = {
+      // Older firmware does not report it, and only builds 1-word headers
+      headerWords: page.packageHeaderWords || DEFAULT_LAYOUT.headerWords,
+      argsTagged: page.packageArgsTagged,
+    };
+    records.push(...decodeLogRecords(page.records, layout));
+    dropped += page.dropped;
+  }
+  return { records, dropped };
+}
@@ -0,0 +1,154 @@
+/**
+ * Typed RPC methods
+ * One function per Request.request_type member, bound from the types that
+ * scripts/rpc_codegen.py generates into proto/zmk/template/custom_rpc.ts.
+ * A method wraps its request in the oneof, answers with the matching
+ * response member and throws error responses, so callers never touch
+ * Request or Response. Batches and paged reads have typed variants too.
+ */
+
+import { Qos, Request, Response } from "./proto/zmk/template/custom";
+import type { DeepPartial } from "./proto/zmk/template/custom";
+import {
+  bindTemplateMethods,
+  RESPONSE_MEMBERS,
+} from "./proto/zmk/template/custom_rpc";
+import type {
+  TemplateMethod,
+  TemplateMethodFns,
+  TemplateMethods,
+  TemplateStreamMethod,
+} from "./proto/zmk/template/custom_rpc";
+import { TemplateRPCError } from "./errors";
+import { awaitJobResult } from "./jobs";
+import type { JobOptions, SubscribeFn } from "./jobs";
+import type { CallFn } from "./transfer";
+
+export type MethodRequest<M extends TemplateMethod> = DeepPartial<
+  TemplateMethods[M]["request"]
+>;
+export type MethodResponse<M extends TemplateMethod> =
+  TemplateMethods[M]["response"];
+
+export type BatchEntry = {
+  [M in TemplateMethod]: { method: M; request: MethodRequest<M> };
+}[Exclude<TemplateMethod, "batch">];
+
+// Outcome of each batch entry, in entry order
+export type BatchResults<E extends readonly BatchEntry[]> = {
+  -readonly [K in keyof E]: E[K] extends {
+    method: infer M extends TemplateMethod;
+  }
+    ? PromiseSettledResult<MethodResponse<M>>
+    : never;
+};
+
+export interface MethodOptions {
+  // Lets requests served by async firmware handlers wait for their job.
+  // Without it their PendingResponse is rejected.
+  subscribe?: SubscribeFn;
+  job?: JobOptions;
+  // Sent with every request. QOS_BULK requests may be held by the firmware
+  // while the keyboard is idle on battery, answering with a PendingResponse,
+  // so they need `subscribe`.
+  qos?: Qos;
+}
+
+// A held bulk job waits for the keyboard to be used, and polling for it
+// would wake the radio, so it is mostly left to its JobResult notification
+const BULK_JOB_OPTIONS: JobOptions = {
+  pollIntervalMs: 60_000,
+  timeoutMs: 10 * 60_000,
+};
+
+export interface TemplateMethodClient extends TemplateMethodFns {
+  // Run the entries in a single BatchRequest round trip
+  batch<const E extends readonly BatchEntry[]>(
+    entries: E
+  ): Promise<BatchResults<E>>;
+  // Repeat a paged read until the device has nothing more to send
+  stream<M extends TemplateStreamMethod>(
+    method: M,
+    request: MethodRequest<M>,
+    maxReads?: number
+  ): AsyncGenerator<MethodResponse<M>>;
+}
+
+function wrapRequest<M extends TemplateMethod>(
+  method: M,
+  request: MethodRequest<M>,
+  qos: Qos = Qos.QOS_NORMAL
+): Request {
+  return Request.create({ [method]: request, qos } as DeepPartial<Request>);
+}
+
+// The response member answering `method`, throwing error responses
+export function unwrapResponse<M extends TemplateMethod>(
+  method: M,
+  resp: Response | null
+): MethodResponse<M> {
+  if (!resp) throw new Error("No response from device");
+  if (resp.error) throw new TemplateRPCError(resp.error);
+  const member = resp[RESPONSE_MEMBERS[method]];
+  if (!member) throw new Error(`Unexpected response to ${method} request`);
+  return member as MethodResponse<M>;
+}
+
+export function templateMethods(
+  call: CallFn,
+  options: MethodOptions = {}
+): TemplateMethodClient {
+  const invoke = async <M extends TemplateMethod>(
+    method: M,
+    request: MethodRequest<M>
+  ): Promise<MethodResponse<M>> => {
+    let resp = await call(wrapRequest(method, request, options.qos));
+    if (resp?.pending) {
+      if (!options.subscribe) {
+        throw new Error(`${method} is answered asynchronously`);
+      }
+      const job =
+        options.qos === Qos.QOS_BULK
+          ? { ...BULK_JOB_OPTIONS, ...options.job }
+          : options.job;
+      resp = await awaitJobResult(call, options.subscribe, resp, job);
+    }
+    return unwrapResponse(method, resp);
+  };
+
+  return {
+    ...bindTemplateMethods(invoke),
+
+    async batch(entries) {
+      const requests = entries.map((entry) =>
+        Request.encode(
+          wrapRequest(entry.method, entry.request, options.qos)
+        ).finish()
+      );
+      const { responses } = await invoke("batch", { requests });
+      const results = entries.map(
+        (entry, i): PromiseSettledResult<unknown> => {
+          const resp = responses[i];
+          try {
+            const value = unwrapResponse(
+              entry.method,
+              resp ? Response.decode(resp) : null
+            );
+            return { status: "fulfilled", value };
+          } catch (reason) {
+            return { status: "rejected", reason };
+          }
+        }
+      );
+      return results as BatchResults<typeof entries>;
+    },
+
+    async *stream(method, request, maxReads = Infinity) {
+      for (let reads = 0; reads < maxReads; reads++) {
+        const page = await invoke(method, request);
+        yield page;
+        if (!page.more) return;
+      }
+    },
+  };
+}
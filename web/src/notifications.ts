@@ -0,0 +1,107 @@
+/**
+ * Template subsystem notifications
+ * Decodes the custom subsystem notifications pushed by the firmware and fans
+ * them out to any number of listeners.
+ */
+
+import { Notification } from "./proto/zmk/template/custom";
+import type { ZMKConnection } from "./rpc";
+
+export type NotificationListener = (notification: Notification) => void;
+
+// Shape of the Studio notifications carrying custom subsystem payloads
+interface StudioNotification {
+  custom?: {
+    customNotification?: {
+      subsystemIndex: number;
+      payload: Uint8Array;
+    };
+  };
+}
+
+interface NotificationSource {
+  notification_readable?: ReadableStream<StudioNotification>;
+}
+
+class NotificationHub {
+  private listeners = new Map<number, Set<NotificationListener>>();
+  private started = false;
+  private readonly source: NotificationSource;
+
+  constructor(source: NotificationSource) {
+    this.source = source;
+  }
+
+  subscribe(subsystemIndex: number, listener: NotificationListener) {
+    let listeners = this.listeners.get(subsystemIndex);
+    if (!listeners) {
+      listeners = new Set();
+      this.listeners.set(subsystemIndex, listeners);
+    }
+    listeners.add(listener);
+    this.start();
+
+    return () => {
+      listeners.delete(listener);
+    };
+  }
+
+  dispatch(notification: StudioNotification) {
+    const custom = notification.custom?.customNotification;
+    if (!custom) return;
+
+    const listeners = this.listeners.get(custom.subsystemIndex);
+    if (!listeners || listeners.size === 0) return;
+
+    let decoded: Notification;
+    try {
+      decoded = Notification.decode(custom.payload);
+    } catch (error) {
+      console.error("Failed to decode notification:", error);
+      return;
+    }
+    listeners.forEach((listener) => listener(decoded));
+  }
+
+  private start() {
+    if (this.started) return;
+    this.started = true;
+
+    const readable = this.source.notification_readable;
+    if (!readable || readable.locked) {
+      console.warn("Studio notification stream is not available");
+      return;
+    }
+
+    const reader = readable.getReader();
+    const pump = async () => {
+      for (;;) {
+        const { done, value } = await reader.read();
+        if (done) return;
+        this.dispatch(value);
+      }
+    };
+    pump().catch((error) => console.error("Notification stream:", error));
+  }
+}
+
+// One reader per connection, since a stream can only be read once
+const hubs = new WeakMap<object, NotificationHub>();
+
+function getHub(connection: ZMKConnection): NotificationHub {
+  let hub = hubs.get(connection);
+  if (!hub) {
+    hub = new NotificationHub(connection as unknown as NotificationSource);
+    hubs.set(connection, hub);
+  }
+  return hub;
+}
+
+// Call `listener` for every notification of the given subsystem
+export function subscribeNotifications(
+  connection: ZMKConnection,
+  subsystemIndex: number,
+  listener: NotificationListener
+): () => void {
+  return getHub(connection).subscribe(subsystemIndex, listener);
+}
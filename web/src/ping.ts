@@ -0,0 +1,135 @@
+/**
+ * Round-trip latency probe
+ * Fires bursts of PingRequests, which the firmware answers without doing any
+ * work, and summarises their round trips. Compared with the handler timings
+ * of StatsPanel this tells transport and framing delays from handler time,
+ * e.g. between serial and BLE on the same keyboard.
+ */
+
+import type { PingResponse } from "./proto/zmk/template/custom";
+import type { TemplateMethodFns } from "./proto/zmk/template/custom_rpc";
+
+export interface PingOptions {
+  count: number;
+  // Pings sent before waiting for a response
+  inFlight?: number;
+  // Bytes echoed by each ping, up to
+  // CONFIG_ZMK_TEMPLATE_FEATURE_STUDIO_RPC_PING_PAYLOAD_MAX_SIZE
+  payloadSize?: number;
+}
+
+export interface PingRun {
+  // Round trip of each answered ping in milliseconds, ascending
+  roundTripsMs: number[];
+  // Pings that failed or came back with another sequence number or payload
+  lost: number;
+  payloadSize: number;
+  // Host time from the first ping sent to the last response
+  elapsedMs: number;
+  // Device time between the first and the last ping handled
+  deviceElapsedMs: number;
+}
+
+export interface PingSummary {
+  p50: number;
+  p99: number;
+  mean: number;
+  max: number;
+  pingsPerSecond: number;
+  // Payload bytes carried per second, both directions
+  payloadBytesPerSecond: number;
+}
+
+type PingFn = TemplateMethodFns["ping"];
+
+// Value below which fraction `p` of `sorted` falls, by nearest rank
+export function percentile(sorted: number[], p: number): number {
+  if (sorted.length === 0) return 0;
+  const rank = Math.ceil(p * sorted.length) - 1;
+  return sorted[Math.min(sorted.length - 1, Math.max(0, rank))];
+}
+
+export function summarizePings(run: PingRun): PingSummary {
+  const trips = run.roundTripsMs;
+  const seconds = run.elapsedMs / 1000;
+  const total = trips.reduce((sum, trip) => sum + trip, 0);
+  return {
+    p50: percentile(trips, 0.5),
+    p99: percentile(trips, 0.99),
+    mean: trips.length ? total / trips.length : 0,
+    max: trips.length ? trips[trips.length - 1] : 0,
+    pingsPerSecond: seconds > 0 ? trips.length / seconds : 0,
+    payloadBytesPerSecond:
+      seconds > 0 ? (2 * run.payloadSize * trips.length) / seconds : 0,
+  };
+}
+
+// Round trips counted into `buckets` equal ranges from 0 to the slowest
+export function pingHistogram(run: PingRun, buckets: number): number[] {
+  const counts = new Array<number>(buckets).fill(0);
+  const max = run.roundTripsMs[run.roundTripsMs.length - 1] ?? 0;
+  for (const trip of run.roundTripsMs) {
+    const bucket = max > 0 ? Math.floor((trip / max) * buckets) : 0;
+    counts[Math.min(buckets - 1, bucket)]++;
+  }
+  return counts;
+}
+
+function deviceMs(resp: PingResponse): number {
+  return resp.cyclesPerSecond
+    ? (resp.deviceCycles / resp.cyclesPerSecond) * 1000
+    : 0;
+}
+
+export async function runPings(
+  ping: PingFn,
+  options: PingOptions,
+  now: () => number = () => performance.now()
+): Promise<PingRun> {
+  const payloadSize = options.payloadSize ?? 0;
+  const payload = Uint8Array.from({ length: payloadSize }, (_, i) => i);
+  const roundTripsMs: number[] = [];
+  const deviceTimes: number[] = [];
+  let lost = 0;
+  let next = 0;
+
+  const sendOne = async (sequence: number) => {
+    try {
+      const resp = await ping({
+        sequence,
+        hostTimeUs: Math.round(now() * 1000),
+        payload,
+      });
+      if (
+        resp.sequence !== sequence ||
+        resp.payload.length !== payload.length
+      ) {
+        lost++;
+        return;
+      }
+      roundTripsMs.push(now() - resp.hostTimeUs / 1000);
+      deviceTimes.push(deviceMs(resp));
+    } catch {
+      lost++;
+    }
+  };
+
+  const worker = async () => {
+    while (next < options.count) await sendOne(next++);
+  };
+
+  const started = now();
+  const workers = Math.max(1, Math.min(options.inFlight ?? 1, options.count));
+  await Promise.all(Array.from({ length: workers }, worker));
+
+  roundTripsMs.sort((a, b) => a - b);
+  return {
+    roundTripsMs,
+    lost,
+    payloadSize,
+    elapsedMs: now() - started,
+    deviceElapsedMs: deviceTimes.length
+      ? Math.max(...deviceTimes) - Math.min(...deviceTimes)
+      : 0,
+  };
+}
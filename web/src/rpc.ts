@@ -0,0 +1,25 @@
+/**
+ * Template subsystem RPC helpers
+ */
+
+import { ZMKCustomSubsystem } from "@cormoran/zmk-studio-react-hook";
+import { Request, Response } from "./proto/zmk/template/custom";
+import { getTemplateClient } from "./client";
+
+// Custom subsystem identifier - must match firmware registration
+export const SUBSYSTEM_IDENTIFIER = "zmk__template";
+
+export type ZMKConnection = ConstructorParameters<typeof ZMKCustomSubsystem>[0];
+
+// Names of the Request.request_type members, keyed by oneof tag
+export { REQUEST_TYPE_NAMES } from "./proto/zmk/template/custom_rpc";
+
+// Encode, send and decode a single request. Concurrent calls share the
+// connection's client and are pipelined.
+export function callTemplateRPC(
+  connection: ZMKConnection,
+  subsystemIndex: number,
+  request: Request
+): Promise<Response | null> {
+  return getTemplateClient(connection, subsystemIndex).call(request);
+}
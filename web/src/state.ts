@@ -0,0 +1,113 @@
+/**
+ * Module state sync
+ * Keeps a local copy of the firmware's ModuleState and refreshes it with
+ * GetStateSinceRequest, which only returns the fields changed since the
+ * version the copy was taken at.
+ */
+
+import {
+  GetStateResponse,
+  ModuleState,
+  Request,
+} from "./proto/zmk/template/custom";
+import { TemplateRPCError } from "./errors";
+import type { CallFn } from "./transfer";
+
+export interface StateSnapshot {
+  epoch: number;
+  version: number;
+  state: ModuleState;
+}
+
+const STORAGE_KEY = "zmk__template:state";
+
+// Fields present in `state`, i.e. those the firmware sent
+function presentFields(state: ModuleState | undefined): ModuleState {
+  return Object.fromEntries(
+    Object.entries(state ?? {}).filter(([, value]) => value !== undefined)
+  ) as ModuleState;
+}
+
+// Apply a GetStateResponse to the local copy
+export function mergeState(
+  current: StateSnapshot | null,
+  resp: GetStateResponse
+): StateSnapshot {
+  const fields = presentFields(resp.state);
+  const base = resp.full || !current || current.epoch !== resp.epoch;
+  return {
+    epoch: resp.epoch,
+    version: resp.version,
+    state: base ? fields : { ...current.state, ...fields },
+  };
+}
+
+async function callState(call: CallFn, request: Request) {
+  const resp = await call(request);
+  if (!resp) throw new Error("No response from device");
+  if (resp.error) throw new TemplateRPCError(resp.error);
+  if (!resp.state) throw new Error("Unexpected response to state request");
+  return resp.state;
+}
+
+// Bring `current` up to date with the firmware
+export async function syncState(
+  call: CallFn,
+  current: StateSnapshot | null
+): Promise<StateSnapshot> {
+  const resp = await callState(
+    call,
+    Request.create({
+      getStateSince: {
+        epoch: current?.epoch ?? 0,
+        version: current?.version ?? 0,
+      },
+    })
+  );
+  return mergeState(current, resp);
+}
+
+// Change some fields and return the updated copy
+export async function updateState(
+  call: CallFn,
+  current: StateSnapshot | null,
+  changes: ModuleState
+): Promise<StateSnapshot> {
+  const resp = await callState(
+    call,
+    Request.create({
+      setState: {
+        state: changes,
+        epoch: current?.epoch ?? 0,
+        version: current?.version ?? 0,
+      },
+    })
+  );
+  return mergeState(current, resp);
+}
+
+// Write pending changes to flash now and return the number of fields saved
+export async function commitState(call: CallFn): Promise<number> {
+  const resp = await call(Request.create({ commit: {} }));
+  if (!resp) throw new Error("No response from device");
+  if (resp.error) throw new TemplateRPCError(resp.error);
+  return resp.commit?.saved ?? 0;
+}
+
+// The copy is persisted so that a reload or reconnect only fetches changes
+export function loadState(): StateSnapshot | null {
+  try {
+    const stored = localStorage.getItem(STORAGE_KEY);
+    return stored ? (JSON.parse(stored) as StateSnapshot) : null;
+  } catch {
+    return null;
+  }
+}
+
+export function saveState(snapshot: StateSnapshot) {
+  try {
+    localStorage.setItem(STORAGE_KEY, JSON.stringify(snapshot));
+  } catch {
+    // Storage may be unavailable or full; the copy just is not persisted
+  }
+}
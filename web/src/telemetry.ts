@@ -0,0 +1,176 @@
+/**
+ * Telemetry store
+ * Keeps data the firmware streams as notifications outside of React state.
+ * Histories are typed-array ring buffers that stop allocating once full, and
+ * subscribers are told about changes at most once per animation frame however
+ * many notifications arrived in it. Components read the store through
+ * useSyncExternalStore or draw it to a canvas (useTelemetry.ts), so a fast
+ * stream costs one render per frame instead of one per notification.
+ */
+
+import type { Notification } from "./proto/zmk/template/custom";
+import { KeyPressCounts } from "./keyEvents";
+import { subscribeNotifications } from "./notifications";
+import type { ZMKConnection } from "./rpc";
+
+// Entries kept by each history
+const DEFAULT_HISTORY_SIZE = 1024;
+
+// Window of the per-second rates
+const RATE_WINDOW_MS = 1000;
+
+// Fixed-size history of numbers, overwriting the oldest once full
+export class RingBuffer {
+  private readonly data: Float64Array;
+  // Index the next value is written to
+  private next = 0;
+  private count = 0;
+
+  constructor(capacity: number) {
+    this.data = new Float64Array(capacity);
+  }
+
+  get capacity(): number {
+    return this.data.length;
+  }
+
+  get length(): number {
+    return this.count;
+  }
+
+  push(value: number) {
+    this.data[this.next] = value;
+    this.next = (this.next + 1) % this.data.length;
+    this.count = Math.min(this.count + 1, this.data.length);
+  }
+
+  // Value `index` from the oldest one kept
+  at(index: number): number | undefined {
+    if (index < 0 || index >= this.count) return undefined;
+    const capacity = this.data.length;
+    return this.data[(this.next - this.count + index + capacity) % capacity];
+  }
+
+  last(): number | undefined {
+    return this.at(this.count - 1);
+  }
+
+  // Number of values >= `min`, for values pushed in ascending order
+  countSince(min: number): number {
+    let n = 0;
+    while (n < this.count && this.at(this.count - 1 - n)! >= min) n++;
+    return n;
+  }
+
+  clear() {
+    this.next = 0;
+    this.count = 0;
+  }
+}
+
+export interface TelemetryOptions {
+  historySize?: number;
+  // Runs `callback` before the next paint, requestAnimationFrame by default
+  schedule?: (callback: () => void) => void;
+  // Host clock of the arrival times in milliseconds
+  now?: () => number;
+}
+
+export class TelemetryStore {
+  readonly keys = new KeyPressCounts();
+  // Arrival times of key presses and of all notifications
+  readonly pressTimes: RingBuffer;
+  readonly notificationTimes: RingBuffer;
+  // Values of SampleNotifications
+  readonly samples: RingBuffer;
+
+  private readonly schedule: (callback: () => void) => void;
+  private readonly now: () => number;
+  private readonly listeners = new Set<() => void>();
+  private version = 0;
+  private scheduled = false;
+  // Fires once the last arrival leaves the rate window
+  private rateExpiry: ReturnType<typeof setTimeout> | undefined;
+
+  constructor(options: TelemetryOptions = {}) {
+    const size = options.historySize ?? DEFAULT_HISTORY_SIZE;
+    this.pressTimes = new RingBuffer(size);
+    this.notificationTimes = new RingBuffer(size);
+    this.samples = new RingBuffer(size);
+    this.schedule =
+      options.schedule ?? ((callback) => requestAnimationFrame(callback));
+    this.now = options.now ?? (() => performance.now());
+  }
+
+  // For useSyncExternalStore: the snapshot is a version bumped once per
+  // frame with changes, the data itself is read from the store
+  subscribe = (listener: () => void): (() => void) => {
+    this.listeners.add(listener);
+    return () => this.listeners.delete(listener);
+  };
+
+  getSnapshot = (): number => this.version;
+
+  addNotification(notification: Notification) {
+    const now = this.now();
+    this.notificationTimes.push(now);
+    if (notification.keyEvents) {
+      for (const event of this.keys.add(notification.keyEvents)) {
+        if (event.pressed) this.pressTimes.push(now);
+      }
+    }
+    if (notification.sample) this.samples.push(notification.sample.value);
+    this.changed();
+
+    // Rates drop to 0 when the stream stops, without further notifications
+    clearTimeout(this.rateExpiry);
+    this.rateExpiry = setTimeout(() => this.changed(), RATE_WINDOW_MS);
+  }
+
+  // Replace the press counts, e.g. with the totals kept by the firmware
+  setKeyCounts(counts: number[]) {
+    this.keys.set(counts);
+    this.changed();
+  }
+
+  clearKeys() {
+    this.keys.clear();
+    this.pressTimes.clear();
+    this.changed();
+  }
+
+  // Entries of a history of arrival times per second, over the last second
+  rate(times: RingBuffer): number {
+    const since = this.now() - RATE_WINDOW_MS;
+    return (times.countSince(since) * 1000) / RATE_WINDOW_MS;
+  }
+
+  private changed() {
+    if (this.scheduled) return;
+    this.scheduled = true;
+    this.schedule(() => {
+      this.scheduled = false;
+      this.version++;
+      this.listeners.forEach((listener) => listener());
+    });
+  }
+}
+
+// One store per connection, fed by its notifications from the first use on
+const stores = new WeakMap<object, TelemetryStore>();
+
+export function getTelemetryStore(
+  connection: ZMKConnection,
+  subsystemIndex: number
+): TelemetryStore {
+  let store = stores.get(connection);
+  if (!store) {
+    const created = new TelemetryStore();
+    subscribeNotifications(connection, subsystemIndex, (notification) =>
+      created.addNotification(notification)
+    );
+    stores.set(connection, created);
+    store = created;
+  }
+  return store;
+}
@@ -0,0 +1,163 @@
+/**
+ * Chunked transfer helpers
+ * Moves blobs larger than one RPC frame using the BeginTransfer / ReadChunk /
+ * WriteChunk / EndTransfer requests.
+ */
+
+import {
+  Request,
+  Response,
+  TransferDirection,
+  TransferResource,
+} from "./proto/zmk/template/custom";
+import { TemplateRPCError } from "./errors";
+
+// Sends one request and resolves with the decoded response
+export type CallFn = (request: Request) => Promise<Response | null>;
+
+export interface TransferOptions {
+  // Number of chunk requests kept in flight at once
+  pipelineDepth?: number;
+}
+
+const DEFAULT_PIPELINE_DEPTH = 4;
+
+let crcTable: Uint32Array | null = null;
+
+// CRC-32 (IEEE), compatible with Zephyr's crc32_ieee_update()
+export function crc32(data: Uint8Array, crc = 0): number {
+  if (!crcTable) {
+    crcTable = new Uint32Array(256);
+    for (let n = 0; n < 256; n++) {
+      let c = n;
+      for (let k = 0; k < 8; k++) {
+        c = c & 1 ? 0xedb88320 ^ (c >>> 1) : c >>> 1;
+      }
+      crcTable[n] = c >>> 0;
+    }
+  }
+  crc = ~crc >>> 0;
+  for (let i = 0; i < data.length; i++) {
+    crc = crcTable[(crc ^ data[i]) & 0xff] ^ (crc >>> 8);
+  }
+  return ~crc >>> 0;
+}
+
+// Call and unwrap, turning error responses into exceptions
+async function callOrThrow(call: CallFn, request: Request): Promise<Response> {
+  const resp = await call(request);
+  if (!resp) throw new Error("No response from device");
+  if (resp.error) throw new TemplateRPCError(resp.error);
+  return resp;
+}
+
+// Run tasks with at most `depth` of them in flight
+async function runPipelined(
+  tasks: (() => Promise<void>)[],
+  depth: number
+): Promise<void> {
+  let next = 0;
+  const worker = async () => {
+    while (next < tasks.length) {
+      await tasks[next++]();
+    }
+  };
+  await Promise.all(
+    Array.from({ length: Math.min(depth, tasks.length) }, worker)
+  );
+}
+
+// Split [0, size) into chunk offsets
+function chunkOffsets(size: number, chunkSize: number): number[] {
+  const offsets: number[] = [];
+  for (let offset = 0; offset < size; offset += chunkSize) {
+    offsets.push(offset);
+  }
+  return offsets;
+}
+
+export async function readTransfer(
+  call: CallFn,
+  resource: TransferResource,
+  options: TransferOptions = {}
+): Promise<Uint8Array> {
+  const begin = (
+    await callOrThrow(
+      call,
+      Request.create({
+        beginTransfer: {
+          resource,
+          direction: TransferDirection.TRANSFER_DIRECTION_READ,
+        },
+      })
+    )
+  ).beginTransfer;
+  if (!begin) throw new Error("Unexpected response to BeginTransfer");
+
+  const { transferId, size, maxChunkSize } = begin;
+  const data = new Uint8Array(size);
+  const tasks = chunkOffsets(size, maxChunkSize).map((offset) => async () => {
+    const chunk = (
+      await callOrThrow(
+        call,
+        Request.create({
+          readChunk: { transferId, offset, length: maxChunkSize },
+        })
+      )
+    ).readChunk;
+    if (!chunk || chunk.offset !== offset) {
+      throw new Error(`Unexpected response to ReadChunk at ${offset}`);
+    }
+    if (crc32(chunk.data) !== chunk.crc32) {
+      throw new Error(`CRC mismatch in chunk at ${offset}`);
+    }
+    data.set(chunk.data, offset);
+  });
+  await runPipelined(tasks, options.pipelineDepth ?? DEFAULT_PIPELINE_DEPTH);
+
+  await callOrThrow(call, Request.create({ endTransfer: { transferId } }));
+  if (crc32(data) !== begin.crc32) {
+    throw new Error("CRC mismatch in transferred blob");
+  }
+  return data;
+}
+
+export async function writeTransfer(
+  call: CallFn,
+  resource: TransferResource,
+  data: Uint8Array,
+  options: TransferOptions = {}
+): Promise<void> {
+  const begin = (
+    await callOrThrow(
+      call,
+      Request.create({
+        beginTransfer: {
+          resource,
+          direction: TransferDirection.TRANSFER_DIRECTION_WRITE,
+          size: data.length,
+        },
+      })
+    )
+  ).beginTransfer;
+  if (!begin) throw new Error("Unexpected response to BeginTransfer");
+
+  const { transferId, maxChunkSize } = begin;
+  const tasks = chunkOffsets(data.length, maxChunkSize).map(
+    (offset) => async () => {
+      const chunk = data.subarray(offset, offset + maxChunkSize);
+      await callOrThrow(
+        call,
+        Request.create({
+          writeChunk: { transferId, offset, data: chunk, crc32: crc32(chunk) },
+        })
+      );
+    }
+  );
+  await runPipelined(tasks, options.pipelineDepth ?? DEFAULT_PIPELINE_DEPTH);
+
+  await callOrThrow(
+    call,
+    Request.create({ endTransfer: { transferId, crc32: crc32(data) } })
+  );
+}
@@ -0,0 +1,30 @@
+/**
+ * Key usage counters
+ * Reads the per-position press counters the firmware keeps while no UI is
+ * connected.
+ */
+
+import { Request } from "./proto/zmk/template/custom";
+import { TemplateRPCError } from "./errors";
+import type { CallFn } from "./transfer";
+
+// UsageStatsResponse.counts holds a little-endian uint16 per key position
+export function decodeUsageCounts(bytes: Uint8Array): number[] {
+  const counts: number[] = [];
+  for (let i = 0; i + 1 < bytes.length; i += 2) {
+    counts.push(bytes[i] | (bytes[i + 1] << 8));
+  }
+  return counts;
+}
+
+// Fetch the counters, optionally clearing them on the device
+export async function fetchUsageCounts(
+  call: CallFn,
+  reset = false
+): Promise<number[]> {
+  const resp = await call(Request.create({ getUsageStats: { reset } }));
+  if (!resp) throw new Error("No response from device");
+  if (resp.error) throw new TemplateRPCError(resp.error);
+  if (!resp.usageStats) throw new Error("Unexpected response to usage request");
+  return decodeUsageCounts(resp.usageStats.counts);
+}
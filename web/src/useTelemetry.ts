@@ -0,0 +1,50 @@
+/**
+ * React hooks reading the telemetry store
+ */
+
+import { useContext, useEffect, useRef, useSyncExternalStore } from "react";
+import type { RefObject } from "react";
+import { ZMKAppContext } from "@cormoran/zmk-studio-react-hook";
+import { SUBSYSTEM_IDENTIFIER } from "./rpc";
+import { getTelemetryStore, TelemetryStore } from "./telemetry";
+
+// Stands in while disconnected, so hooks are always called with a store
+const DISCONNECTED_STORE = new TelemetryStore();
+
+// The connection's store, without re-rendering when it changes
+export function useTelemetryStore(): TelemetryStore {
+  const zmkApp = useContext(ZMKAppContext);
+  const connection = zmkApp?.state.connection;
+  const subsystemIndex = zmkApp?.findSubsystem(SUBSYSTEM_IDENTIFIER)?.index;
+  if (!connection || subsystemIndex === undefined) return DISCONNECTED_STORE;
+  return getTelemetryStore(connection, subsystemIndex);
+}
+
+// The connection's store, re-rendering at most once per animation frame
+export function useTelemetry(): TelemetryStore {
+  const store = useTelemetryStore();
+  useSyncExternalStore(store.subscribe, store.getSnapshot);
+  return store;
+}
+
+// Draw the store to `canvasRef` after every frame in which it changed,
+// without re-rendering. The latest `draw` is used without resubscribing.
+export function useTelemetryCanvas(
+  store: TelemetryStore,
+  canvasRef: RefObject<HTMLCanvasElement | null>,
+  draw: (canvas: HTMLCanvasElement, store: TelemetryStore) => void
+) {
+  const drawRef = useRef(draw);
+
+  useEffect(() => {
+    drawRef.current = draw;
+  }, [draw]);
+
+  useEffect(() => {
+    const redraw = () => {
+      if (canvasRef.current) drawRef.current(canvasRef.current, store);
+    };
+    redraw();
+    return store.subscribe(redraw);
+  }, [store, canvasRef]);
+}
@@ -0,0 +1,29 @@
+/**
+ * React hook subscribing to template subsystem notifications
+ */
+
+import { useContext, useEffect, useRef } from "react";
+import { ZMKAppContext } from "@cormoran/zmk-studio-react-hook";
+import { NotificationListener, subscribeNotifications } from "./notifications";
+import { SUBSYSTEM_IDENTIFIER } from "./rpc";
+
+// Call `listener` for every notification pushed by the firmware while the
+// device is connected. The latest `listener` is used without resubscribing.
+export function useTemplateNotifications(listener: NotificationListener) {
+  const zmkApp = useContext(ZMKAppContext);
+  const listenerRef = useRef(listener);
+
+  useEffect(() => {
+    listenerRef.current = listener;
+  }, [listener]);
+
+  const connection = zmkApp?.state.connection;
+  const subsystemIndex = zmkApp?.findSubsystem(SUBSYSTEM_IDENTIFIER)?.index;
+
+  useEffect(() => {
+    if (!connection || subsystemIndex === undefined) return;
+    return subscribeNotifications(connection, subsystemIndex, (n) =>
+      listenerRef.current(n)
+    );
+  }, [connection, subsystemIndex]);
+}
@@ -0,0 +1,91 @@
+/**
+ * React hook keeping the firmware module state in sync
+ */
+
+import { useCallback, useContext, useEffect, useRef, useState } from "react";
+import { ZMKAppContext } from "@cormoran/zmk-studio-react-hook";
+import { ModuleState } from "./proto/zmk/template/custom";
+import { callTemplateRPC, SUBSYSTEM_IDENTIFIER } from "./rpc";
+import {
+  commitState,
+  loadState,
+  saveState,
+  StateSnapshot,
+  syncState,
+  updateState,
+} from "./state";
+import type { CallFn } from "./transfer";
+import { useTemplateNotifications } from "./useTemplateNotifications";
+
+type StateOp = (
+  call: CallFn,
+  current: StateSnapshot | null
+) => Promise<StateSnapshot>;
+
+// Sync on connect and whenever the firmware announces a newer version
+export function useTemplateState() {
+  const zmkApp = useContext(ZMKAppContext);
+  const [snapshot, setSnapshot] = useState<StateSnapshot | null>(loadState);
+  const [error, setError] = useState<string | null>(null);
+  const snapshotRef = useRef(snapshot);
+
+  const connection = zmkApp?.state.connection;
+  const subsystemIndex = zmkApp?.findSubsystem(SUBSYSTEM_IDENTIFIER)?.index;
+
+  const run = useCallback(
+    async (op: StateOp) => {
+      if (!connection || subsystemIndex === undefined) return;
+      try {
+        const next = await op(
+          (request) => callTemplateRPC(connection, subsystemIndex, request),
+          snapshotRef.current
+        );
+        snapshotRef.current = next;
+        setSnapshot(next);
+        saveState(next);
+        setError(null);
+      } catch (e) {
+        setError(e instanceof Error ? e.message : "Unknown error");
+      }
+    },
+    [connection, subsystemIndex]
+  );
+
+  useEffect(() => {
+    run(syncState);
+  }, [run]);
+
+  useTemplateNotifications((notification) => {
+    const changed = notification.stateChanged;
+    const current = snapshotRef.current;
+    if (
+      changed &&
+      (!current ||
+        changed.epoch !== current.epoch ||
+        changed.version > current.version)
+    ) {
+      run(syncState);
+    }
+  });
+
+  const update = useCallback(
+    (changes: ModuleState) =>
+      run((call, current) => updateState(call, current, changes)),
+    [run]
+  );
+
+  // Save pending changes without waiting for the firmware's debounce delay
+  const commit = useCallback(async () => {
+    if (!connection || subsystemIndex === undefined) return 0;
+    try {
+      return await commitState((request) =>
+        callTemplateRPC(connection, subsystemIndex, request)
+      );
+    } catch (e) {
+      setError(e instanceof Error ? e.message : "Unknown error");
+      return 0;
+    }
+  }, [connection, subsystemIndex]);
+
+  return { state: snapshot?.state ?? null, update, commit, error };
+}
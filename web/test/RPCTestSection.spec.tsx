@@ -33,6 +33,7 @@ describe("RPCTestSection Component", () => {
       expect(screen.getByText(/Send a sample request/i)).toBeInTheDocument();
       expect(screen.getByLabelText(/Value:/i)).toBeInTheDocument();
       expect(screen.getByText(/Send Request/i)).toBeInTheDocument();
+      expect(screen.getByText(/as Batch/i)).toBeInTheDocument();
     });
 
     it("should show default input value", () => {
@@ -0,0 +1,41 @@
+/**
+ * Tests for StatsPanel component
+ */
+
+import { render, screen } from "@testing-library/react";
+import {
+  createConnectedMockZMKApp,
+  ZMKAppProvider,
+} from "@cormoran/zmk-studio-react-hook/testing";
+import { StatsPanel } from "../src/StatsPanel";
+import { SUBSYSTEM_IDENTIFIER } from "../src/rpc";
+
+describe("StatsPanel Component", () => {
+  it("should render refresh controls when subsystem is found", () => {
+    const mockZMKApp = createConnectedMockZMKApp({
+      subsystems: [SUBSYSTEM_IDENTIFIER],
+    });
+
+    render(
+      <ZMKAppProvider value={mockZMKApp}>
+        <StatsPanel />
+      </ZMKAppProvider>
+    );
+
+    expect(screen.getByText(/RPC Stats/i)).toBeInTheDocument();
+    expect(screen.getByText(/Refresh Stats/i)).toBeInTheDocument();
+    expect(screen.getByLabelText(/Reset after read/i)).toBeInTheDocument();
+  });
+
+  it("should not render when subsystem is not found", () => {
+    const mockZMKApp = createConnectedMockZMKApp({ subsystems: [] });
+
+    const { container } = render(
+      <ZMKAppProvider value={mockZMKApp}>
+        <StatsPanel />
+      </ZMKAppProvider>
+    );
+
+    expect(container.firstChild).toBeNull();
+  });
+});
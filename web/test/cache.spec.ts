@@ -0,0 +1,68 @@
+/**
+ * Tests for the read response cache
+ */
+
+import { Request, Response } from "../src/proto/zmk/template/custom";
+import { ResponseCache } from "../src/cache";
+
+const stateRequest = (version: number) =>
+  Request.create({ getStateSince: { epoch: 1, version } });
+
+const stateResponse = (stateVersion: number) =>
+  Response.create({ stateVersion, state: { epoch: 1, version: stateVersion } });
+
+describe("ResponseCache", () => {
+  it("should only key cacheable reads", () => {
+    const cache = new ResponseCache();
+    const sample = Request.create({ sample: { value: 1 } });
+    expect(cache.keyOf(stateRequest(0))).toBeDefined();
+    expect(cache.keyOf(sample)).toBeUndefined();
+  });
+
+  it("should ignore the request ID in keys", () => {
+    const cache = new ResponseCache();
+    expect(cache.keyOf({ ...stateRequest(0), requestId: 7 })).toBe(
+      cache.keyOf(stateRequest(0))
+    );
+    expect(cache.keyOf(stateRequest(1))).not.toBe(
+      cache.keyOf(stateRequest(0))
+    );
+  });
+
+  it("should drop entries when the state version changes", () => {
+    const cache = new ResponseCache();
+    const key = cache.keyOf(stateRequest(0))!;
+    cache.observeVersion(3);
+    cache.set(key, stateResponse(3));
+    expect(cache.get(key)?.state?.version).toBe(3);
+
+    cache.observeVersion(4);
+    expect(cache.get(key)).toBeUndefined();
+  });
+
+  it("should not keep stale or failed responses", () => {
+    const cache = new ResponseCache();
+    const key = cache.keyOf(stateRequest(0))!;
+    cache.observeVersion(4);
+
+    cache.set(key, stateResponse(3));
+    cache.set(key, Response.create({ stateVersion: 4, error: { code: 3 } }));
+    expect(cache.size).toBe(0);
+  });
+
+  it("should evict the least recently used entry", () => {
+    const cache = new ResponseCache(2);
+    const keys = [0, 1, 2].map(
+      (version) => cache.keyOf(stateRequest(version))!
+    );
+
+    cache.set(keys[0], stateResponse(0));
+    cache.set(keys[1], stateResponse(0));
+    cache.get(keys[0]);
+    cache.set(keys[2], stateResponse(0));
+
+    expect(cache.get(keys[0])).toBeDefined();
+    expect(cache.get(keys[1])).toBeUndefined();
+    expect(cache.get(keys[2])).toBeDefined();
+  });
+});
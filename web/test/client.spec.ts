@@ -0,0 +1,325 @@
+/**
+ * Tests for the pipelining RPC client
+ *
+ * The device is a fake transport that answers sample requests in whatever
+ * order the test releases them.
+ */
+
+import {
+  Compression,
+  ErrorCode,
+  Request,
+  Response,
+} from "../src/proto/zmk/template/custom";
+import { ResponseCache } from "../src/cache";
+import { TemplateRPCClient } from "../src/client";
+
+function createFakeDevice() {
+  const waiting: { request: Request; release: () => void }[] = [];
+
+  const send = (payload: Uint8Array) =>
+    new Promise<Uint8Array>((resolve) => {
+      const request = Request.decode(payload);
+      waiting.push({
+        request,
+        release: () =>
+          resolve(
+            Response.encode(
+              Response.create({
+                requestId: request.requestId,
+                sample: { value: `echo ${request.sample?.value}` },
+              })
+            ).finish()
+          ),
+      });
+    });
+
+  return { send, waiting };
+}
+
+// Answers right away, unpacking batches like the firmware. Sample values
+// listed in `tooLarge` do not fit a batch slot.
+function createBatchDevice(tooLarge: number[] = []) {
+  const received: Request[] = [];
+
+  const answer = (request: Request, inBatch: boolean): Response => {
+    if (request.batch) {
+      return Response.create({
+        requestId: request.requestId,
+        batch: {
+          responses: request.batch.requests.map((entry) =>
+            Response.encode(answer(Request.decode(entry), true)).finish()
+          ),
+        },
+      });
+    }
+    const value = request.sample?.value ?? 0;
+    if (inBatch && tooLarge.includes(value)) {
+      return Response.create({
+        error: { code: ErrorCode.ERROR_CODE_RESPONSE_TOO_LARGE },
+      });
+    }
+    return Response.create({
+      requestId: request.requestId,
+      sample: { value: `echo ${value}` },
+    });
+  };
+
+  const send = async (payload: Uint8Array) => {
+    const request = Request.decode(payload);
+    received.push(request);
+    return Response.encode(answer(request, false)).finish();
+  };
+
+  return { send, received };
+}
+
+const flush = () => new Promise((resolve) => setTimeout(resolve, 0));
+const sleep = (ms: number) => new Promise((resolve) => setTimeout(resolve, ms));
+
+describe("TemplateRPCClient", () => {
+  it("should tag requests with distinct IDs", async () => {
+    const device = createFakeDevice();
+    const client = new TemplateRPCClient(device.send);
+
+    client.call(Request.create({ sample: { value: 1 } }));
+    client.call(Request.create({ sample: { value: 2 } }));
+    await flush();
+
+    const ids = device.waiting.map((w) => w.request.requestId);
+    expect(ids).toHaveLength(2);
+    expect(ids[0]).not.toBe(0);
+    expect(ids[0]).not.toBe(ids[1]);
+  });
+
+  it("should resolve calls in the order responses arrive", async () => {
+    const device = createFakeDevice();
+    const client = new TemplateRPCClient(device.send);
+
+    const first = client.call(Request.create({ sample: { value: 1 } }));
+    const second = client.call(Request.create({ sample: { value: 2 } }));
+    await flush();
+
+    device.waiting[1].release();
+    device.waiting[0].release();
+
+    expect((await first)?.sample?.value).toBe("echo 1");
+    expect((await second)?.sample?.value).toBe("echo 2");
+  });
+
+  it("should route a response to the request ID it carries", async () => {
+    // A transport that hands out responses in arrival order rather than per
+    // call, like a shared serial link
+    const requests: Request[] = [];
+    const resolvers: ((payload: Uint8Array) => void)[] = [];
+    const client = new TemplateRPCClient(
+      (payload) =>
+        new Promise((resolve) => {
+          requests.push(Request.decode(payload));
+          resolvers.push(resolve);
+        })
+    );
+
+    const first = client.call(Request.create({ sample: { value: 1 } }));
+    const second = client.call(Request.create({ sample: { value: 2 } }));
+    await flush();
+
+    requests.reverse().forEach((request, i) =>
+      resolvers[i](
+        Response.encode(
+          Response.create({
+            requestId: request.requestId,
+            sample: { value: `echo ${request.sample?.value}` },
+          })
+        ).finish()
+      )
+    );
+
+    expect((await first)?.sample?.value).toBe("echo 1");
+    expect((await second)?.sample?.value).toBe("echo 2");
+  });
+
+  it("should queue calls beyond maxInFlight", async () => {
+    const device = createFakeDevice();
+    const client = new TemplateRPCClient(device.send, { maxInFlight: 2 });
+
+    const calls = [1, 2, 3].map((value) =>
+      client.call(Request.create({ sample: { value } }))
+    );
+    await flush();
+    expect(device.waiting).toHaveLength(2);
+    expect(client.inFlightCount).toBe(2);
+
+    device.waiting[0].release();
+    await calls[0];
+    await flush();
+    expect(device.waiting).toHaveLength(3);
+
+    device.waiting[1].release();
+    device.waiting[2].release();
+    const responses = await Promise.all(calls);
+    expect(responses.map((r) => r?.sample?.value)).toEqual([
+      "echo 1",
+      "echo 2",
+      "echo 3",
+    ]);
+    expect(client.inFlightCount).toBe(0);
+  });
+
+  it("should accept and decompress compressed responses", async () => {
+    const requests: Request[] = [];
+    const client = new TemplateRPCClient(async (payload) => {
+      requests.push(Request.decode(payload));
+      return Response.encode(
+        Response.create({
+          compression: Compression.COMPRESSION_RLE,
+          usageStats: { counts: Uint8Array.from([0x80, 0]) },
+        })
+      ).finish();
+    });
+
+    const response = await client.call(
+      Request.create({ getUsageStats: { reset: false } })
+    );
+
+    expect(requests[0].acceptCompression).toBe(Compression.COMPRESSION_RLE);
+    expect(response?.usageStats?.counts).toEqual(new Uint8Array(3));
+  });
+
+  it("should answer repeated reads from the cache", async () => {
+    let stateVersion = 1;
+    const requests: Request[] = [];
+    const client = new TemplateRPCClient(
+      async (payload) => {
+        requests.push(Request.decode(payload));
+        return Response.encode(
+          Response.create({ stateVersion, state: { version: stateVersion } })
+        ).finish();
+      },
+      { cache: new ResponseCache() }
+    );
+    const read = () =>
+      client.call(Request.create({ getStateSince: { epoch: 1, version: 0 } }));
+
+    await read();
+    expect((await read())?.state?.version).toBe(1);
+    expect(requests).toHaveLength(1);
+
+    stateVersion = 2;
+    client.observeStateVersion(2);
+    expect((await read())?.state?.version).toBe(2);
+    expect(requests).toHaveLength(2);
+  });
+
+  it("should reject the call whose transport fails", async () => {
+    const client = new TemplateRPCClient(() =>
+      Promise.reject(new Error("disconnected"))
+    );
+
+    const result = client.call(Request.create({ sample: { value: 1 } }));
+    await expect(result).rejects.toThrow("disconnected");
+  });
+
+  describe("with packing", () => {
+    const samples = (client: TemplateRPCClient, values: number[]) =>
+      Promise.all(
+        values.map((value) =>
+          client.call(Request.create({ sample: { value } }))
+        )
+      );
+
+    it("should pack queued requests into one batch", async () => {
+      const device = createBatchDevice();
+      const client = new TemplateRPCClient(device.send, {
+        packing: { frameBytes: 200, maxDelayMs: 1 },
+      });
+
+      const responses = await samples(client, [1, 2, 3]);
+
+      expect(device.received).toHaveLength(1);
+      expect(device.received[0].batch?.requests).toHaveLength(3);
+      expect(responses.map((r) => r?.sample?.value)).toEqual([
+        "echo 1",
+        "echo 2",
+        "echo 3",
+      ]);
+    });
+
+    it("should send a lone request unwrapped after the delay", async () => {
+      const device = createBatchDevice();
+      const client = new TemplateRPCClient(device.send, {
+        packing: { frameBytes: 200, maxDelayMs: 20 },
+      });
+
+      const response = client.call(Request.create({ sample: { value: 1 } }));
+      await flush();
+      expect(device.received).toHaveLength(0);
+
+      await sleep(30);
+      expect(device.received).toHaveLength(1);
+      expect(device.received[0].sample?.value).toBe(1);
+      expect((await response)?.sample?.value).toBe("echo 1");
+    });
+
+    it("should start a new frame once one is full", async () => {
+      const device = createBatchDevice();
+      const client = new TemplateRPCClient(device.send, {
+        packing: { frameBytes: 200, maxDelayMs: 1, maxEntries: 2 },
+      });
+
+      await samples(client, [1, 2, 3]);
+
+      expect(device.received).toHaveLength(2);
+      expect(device.received[0].batch?.requests).toHaveLength(2);
+      expect(device.received[1].sample?.value).toBe(3);
+    });
+
+    it("should not pack past frameBytes", async () => {
+      const device = createBatchDevice();
+      const client = new TemplateRPCClient(device.send, {
+        packing: { frameBytes: 16, maxDelayMs: 1 },
+      });
+
+      await samples(client, [1, 2]);
+
+      expect(device.received).toHaveLength(2);
+      expect(device.received.every((r) => !r.batch)).toBe(true);
+    });
+
+    it("should resend an entry whose response is too large", async () => {
+      const device = createBatchDevice([2]);
+      const client = new TemplateRPCClient(device.send, {
+        packing: { frameBytes: 200, maxDelayMs: 1 },
+      });
+
+      const responses = await samples(client, [1, 2, 3]);
+
+      expect(device.received).toHaveLength(2);
+      expect(device.received[1].sample?.value).toBe(2);
+      expect(responses.map((r) => r?.sample?.value)).toEqual([
+        "echo 1",
+        "echo 2",
+        "echo 3",
+      ]);
+    });
+
+    it("should send batch requests as they are", async () => {
+      const device = createBatchDevice();
+      const client = new TemplateRPCClient(device.send, {
+        packing: { frameBytes: 200, maxDelayMs: 1 },
+      });
+      const entry = Request.encode(
+        Request.create({ sample: { value: 1 } })
+      ).finish();
+
+      await Promise.all([
+        client.call(Request.create({ batch: { requests: [entry] } })),
+        client.call(Request.create({ sample: { value: 2 } })),
+      ]);
+
+      expect(device.received).toHaveLength(2);
+      expect(device.received[0].batch?.requests).toHaveLength(1);
+      expect(device.received[1].sample?.value).toBe(2);
+    });
+  });
+});
@@ -0,0 +1,71 @@
+/**
+ * Tests for response decompression
+ */
+
+import { Compression, Response } from "../src/proto/zmk/template/custom";
+import { decodeRLE, decompressResponse } from "../src/compression";
+
+describe("decodeRLE", () => {
+  it("should copy literals", () => {
+    expect(decodeRLE(Uint8Array.from([2, 7, 8, 9]))).toEqual(
+      Uint8Array.from([7, 8, 9])
+    );
+  });
+
+  it("should expand runs", () => {
+    // 0x80 repeats the next byte 3 times, 0xff 130 times
+    expect(decodeRLE(Uint8Array.from([0x80, 5]))).toEqual(
+      Uint8Array.from([5, 5, 5])
+    );
+    expect(decodeRLE(Uint8Array.from([0xff, 0]))).toEqual(new Uint8Array(130));
+  });
+
+  it("should decode a usage table", () => {
+    const data = Uint8Array.from([3, 5, 0, 12, 0, 0x83, 0, 1, 1, 0]);
+    expect(decodeRLE(data)).toEqual(
+      Uint8Array.from([5, 0, 12, 0, 0, 0, 0, 0, 0, 0, 1, 0])
+    );
+  });
+
+  it("should reject truncated data", () => {
+    expect(() => decodeRLE(Uint8Array.from([3, 1, 2]))).toThrow(
+      "Truncated RLE literal"
+    );
+    expect(() => decodeRLE(Uint8Array.from([0x80]))).toThrow(
+      "Truncated RLE run"
+    );
+  });
+});
+
+describe("decompressResponse", () => {
+  it("should restore the usage counters", () => {
+    const response = decompressResponse(
+      Response.create({
+        compression: Compression.COMPRESSION_RLE,
+        usageStats: { counts: Uint8Array.from([0x81, 0]) },
+      })
+    );
+
+    expect(response.compression).toBe(Compression.COMPRESSION_NONE);
+    expect(response.usageStats?.counts).toEqual(new Uint8Array(4));
+  });
+
+  it("should restore read chunk data", () => {
+    const response = decompressResponse(
+      Response.create({
+        compression: Compression.COMPRESSION_RLE,
+        readChunk: { offset: 8, data: Uint8Array.from([0x80, 0xaa]) },
+      })
+    );
+
+    expect(response.readChunk?.offset).toBe(8);
+    expect(response.readChunk?.data).toEqual(
+      Uint8Array.from([0xaa, 0xaa, 0xaa])
+    );
+  });
+
+  it("should leave uncompressed responses alone", () => {
+    const response = Response.create({ sample: { value: "ok" } });
+    expect(decompressResponse(response)).toBe(response);
+  });
+});
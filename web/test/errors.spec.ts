@@ -0,0 +1,55 @@
+/**
+ * Tests for error response text
+ */
+
+import { ErrorCode, ErrorResponse } from "../src/proto/zmk/template/custom";
+import { describeError, TemplateRPCError } from "../src/errors";
+
+describe("describeError", () => {
+  it("should describe a code without a message", () => {
+    const error = ErrorResponse.create({
+      code: ErrorCode.ERROR_CODE_INVALID_ARGUMENT,
+      errnoValue: -22,
+    });
+    expect(describeError(error)).toBe("Invalid argument (EINVAL)");
+  });
+
+  it("should append the message of debug firmware", () => {
+    const error = ErrorResponse.create({
+      code: ErrorCode.ERROR_CODE_HANDLER_FAILED,
+      errnoValue: -5,
+      message: "Sensor read failed",
+    });
+    expect(describeError(error)).toBe(
+      "Failed to process request (EIO): Sensor read failed"
+    );
+  });
+
+  it("should fall back to numbers for unknown values", () => {
+    const error = ErrorResponse.create({
+      code: 99 as ErrorCode,
+      errnoValue: -200,
+    });
+    expect(describeError(error)).toBe("Error code 99 (errno 200)");
+  });
+
+  it("should keep the message of firmware without codes", () => {
+    const error = ErrorResponse.create({ message: "Unsupported" });
+    expect(describeError(error)).toBe("Unsupported");
+  });
+});
+
+describe("TemplateRPCError", () => {
+  it("should carry the code and errno", () => {
+    const error = new TemplateRPCError(
+      ErrorResponse.create({
+        code: ErrorCode.ERROR_CODE_BUSY,
+        errnoValue: -16,
+      })
+    );
+    expect(error).toBeInstanceOf(Error);
+    expect(error.message).toBe("Device busy, try again (EBUSY)");
+    expect(error.code).toBe(ErrorCode.ERROR_CODE_BUSY);
+    expect(error.errnoValue).toBe(-16);
+  });
+});
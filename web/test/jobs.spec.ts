@@ -0,0 +1,130 @@
+/**
+ * Tests for async job result handling
+ */
+
+import {
+  Compression,
+  Notification,
+  Request,
+  Response,
+} from "../src/proto/zmk/template/custom";
+import { awaitJobResult } from "../src/jobs";
+import type { NotificationListener } from "../src/notifications";
+
+const result = Response.create({ sample: { value: "done" } });
+const pending = Response.create({ pending: { jobId: 3 } });
+
+function createSubscribe() {
+  const listeners = new Set<NotificationListener>();
+  const subscribe = (listener: NotificationListener) => {
+    listeners.add(listener);
+    return () => listeners.delete(listener);
+  };
+  const push = (notification: Notification) =>
+    listeners.forEach((listener) => listener(notification));
+  return { subscribe, push, listeners };
+}
+
+describe("awaitJobResult", () => {
+  it("should pass through responses that are not pending", async () => {
+    const call = jest.fn();
+    const { subscribe } = createSubscribe();
+
+    expect(await awaitJobResult(call, subscribe, result)).toBe(result);
+    expect(call).not.toHaveBeenCalled();
+  });
+
+  it("should resolve from the job result notification", async () => {
+    const call = jest.fn();
+    const { subscribe, push, listeners } = createSubscribe();
+
+    const promise = awaitJobResult(call, subscribe, pending);
+    push(
+      Notification.create({
+        jobResult: {
+          jobId: 3,
+          done: true,
+          response: Response.encode(result).finish(),
+        },
+      })
+    );
+
+    expect((await promise).sample?.value).toBe("done");
+    expect(listeners.size).toBe(0);
+  });
+
+  it("should fetch a response left out of the notification", async () => {
+    const call = jest.fn(async () =>
+      Response.create({
+        jobResult: {
+          jobId: 3,
+          done: true,
+          response: Response.encode(result).finish(),
+        },
+      })
+    );
+    const { subscribe, push } = createSubscribe();
+
+    const promise = awaitJobResult(call, subscribe, pending, {
+      pollIntervalMs: 60_000,
+    });
+    push(Notification.create({ jobResult: { jobId: 3, done: true } }));
+
+    expect((await promise).sample?.value).toBe("done");
+    expect(call).toHaveBeenCalledTimes(1);
+  });
+
+  it("should decompress the job's response", async () => {
+    const call = jest.fn();
+    const { subscribe, push } = createSubscribe();
+    // A run of five zero bytes
+    const compressed = Response.create({
+      usageStats: { counts: Uint8Array.from([0x82, 0]) },
+      compression: Compression.COMPRESSION_RLE,
+    });
+
+    const promise = awaitJobResult(call, subscribe, pending);
+    push(
+      Notification.create({
+        jobResult: {
+          jobId: 3,
+          done: true,
+          response: Response.encode(compressed).finish(),
+        },
+      })
+    );
+
+    expect((await promise).usageStats?.counts).toEqual(new Uint8Array(5));
+  });
+
+  it("should poll when no notification arrives", async () => {
+    const call = jest.fn(async (request: Request) =>
+      Response.create({
+        jobResult: {
+          jobId: request.getJobResult?.jobId,
+          done: true,
+          response: Response.encode(result).finish(),
+        },
+      })
+    );
+    const { subscribe } = createSubscribe();
+
+    const resp = await awaitJobResult(call, subscribe, pending, {
+      pollIntervalMs: 1,
+    });
+
+    expect(resp.sample?.value).toBe("done");
+    expect(call.mock.calls[0][0].getJobResult).toEqual({ jobId: 3 });
+  });
+
+  it("should reject when the job is unknown", async () => {
+    const call = async () =>
+      Response.create({ error: { message: "Failed to process request" } });
+    const { subscribe } = createSubscribe();
+
+    const promise = awaitJobResult(call, subscribe, pending, {
+      pollIntervalMs: 1,
+    });
+    await expect(promise).rejects.toThrow("Failed to process request");
+  });
+});
@@ -0,0 +1,74 @@
+/**
+ * Tests for key event stream decoding
+ */
+
+import { KeyEventBatch } from "../src/proto/zmk/template/custom";
+import { decodeKeyEvents, KeyPressCounts } from "../src/keyEvents";
+
+// Packs events like the firmware: position << 1 | pressed, then delta ms
+function packEvents(events: [number, boolean, number][]): Uint8Array {
+  const bytes: number[] = [];
+  const putVarint = (value: number) => {
+    do {
+      const byte = value & 0x7f;
+      value = Math.floor(value / 128);
+      bytes.push(value ? byte | 0x80 : byte);
+    } while (value);
+  };
+  for (const [position, pressed, deltaMs] of events) {
+    putVarint(position * 2 + (pressed ? 1 : 0));
+    putVarint(deltaMs);
+  }
+  return Uint8Array.from(bytes);
+}
+
+describe("decodeKeyEvents", () => {
+  it("should restore positions and absolute times", () => {
+    const batch = KeyEventBatch.create({
+      startMs: 1000,
+      count: 3,
+      events: packEvents([
+        [3, true, 0],
+        [3, false, 200],
+        [70, true, 5],
+      ]),
+    });
+
+    expect(decodeKeyEvents(batch)).toEqual([
+      { position: 3, pressed: true, timeMs: 1000 },
+      { position: 3, pressed: false, timeMs: 1200 },
+      { position: 70, pressed: true, timeMs: 1205 },
+    ]);
+  });
+
+  it("should reject a truncated batch", () => {
+    const events = packEvents([[100, true, 300]]);
+    const batch = KeyEventBatch.create({ events: events.subarray(0, 3) });
+    expect(() => decodeKeyEvents(batch)).toThrow("Truncated");
+  });
+});
+
+describe("KeyPressCounts", () => {
+  it("should count presses per position", () => {
+    const counts = new KeyPressCounts();
+    counts.add(
+      KeyEventBatch.create({
+        events: packEvents([
+          [1, true, 0],
+          [1, false, 10],
+          [1, true, 10],
+          [4, true, 10],
+        ]),
+        dropped: 2,
+      })
+    );
+
+    expect(counts.counts[1]).toBe(2);
+    expect(counts.counts[4]).toBe(1);
+    expect(counts.max).toBe(2);
+    expect(counts.dropped).toBe(2);
+
+    counts.clear();
+    expect(counts.max).toBe(0);
+  });
+});
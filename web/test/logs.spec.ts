@@ -0,0 +1,132 @@
+/**
+ * Tests for captured log decoding
+ */
+
+import { Request, Response } from "../src/proto/zmk/template/custom";
+import { decodeLogRecords, formatLogRecord, readLogs } from "../src/logs";
+
+// A warning from source 1 at 1.234 s: format string at 0x1000 with the
+// arguments 42 and the copied string "hi"
+const RECORD = Uint8Array.from([
+  // timestamp, source ID, level, package length
+  0xd2, 0x04, 0, 0, 1, 0, 2, 20,
+  // package header: 4 words, 1 appended string
+  4, 1, 0, 0,
+  // format string address and arguments
+  0x00, 0x10, 0, 0, 42, 0, 0, 0, 0, 0, 0, 0,
+  // the string of the argument in word 3
+  3, 0x68, 0x69, 0,
+]);
+
+// An info message at 0 s: format string at 0x1004 with the 64-bit argument
+// 5 and the copied string "scan", after the 2-word header that
+// CONFIG_CBPRINTF_PACKAGE_HEADER_STORE_CREATION_FLAGS builds
+const LONG_RECORD = Uint8Array.from([
+  // timestamp, source ID, level, package length
+  0, 0, 0, 0, 1, 0, 3, 30,
+  // package header: 6 words, 1 appended string, creation flags
+  6, 1, 0, 0, 0, 0, 0, 0,
+  // format string address and arguments
+  0x04, 0x10, 0, 0, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  // the string of the argument in word 5
+  5, 0x73, 0x63, 0x61, 0x6e, 0,
+]);
+
+const DICTIONARY = {
+  strings: { 0x1000: "value %d from %s", 0x1004: "took %lld us in %s" },
+  sources: { 1: "zmk" },
+};
+
+describe("decodeLogRecords", () => {
+  it("should decode the header and package", () => {
+    const [record] = decodeLogRecords(RECORD);
+
+    expect(record.timestampMs).toBe(1234);
+    expect(record.sourceId).toBe(1);
+    expect(record.level).toBe(2);
+    expect(record.format).toBe(0x1000);
+    expect(record.args).toEqual([42, 0]);
+    expect(record.strings.get(1)).toBe("hi");
+  });
+
+  it("should split consecutive records", () => {
+    const records = new Uint8Array(RECORD.length * 2);
+    records.set(RECORD);
+    records.set(RECORD, RECORD.length);
+    expect(decodeLogRecords(records)).toHaveLength(2);
+  });
+
+  it("should find the arguments after a longer package header", () => {
+    const [record] = decodeLogRecords(LONG_RECORD, {
+      headerWords: 2,
+      argsTagged: false,
+    });
+
+    expect(record.format).toBe(0x1004);
+    expect(record.args).toEqual([5, 0, 0]);
+    expect(record.strings.get(2)).toBe("scan");
+  });
+
+  it("should reject a truncated record", () => {
+    expect(() => decodeLogRecords(RECORD.subarray(0, 12))).toThrow(
+      "Truncated log record"
+    );
+  });
+});
+
+describe("formatLogRecord", () => {
+  it("should format the message with a dictionary", () => {
+    const [record] = decodeLogRecords(RECORD);
+    expect(formatLogRecord(record, DICTIONARY)).toBe(
+      "[    1.234] <wrn> zmk: value 42 from hi"
+    );
+  });
+
+  it("should find strings after a 64-bit argument", () => {
+    const [record] = decodeLogRecords(LONG_RECORD, {
+      headerWords: 2,
+      argsTagged: false,
+    });
+    expect(formatLogRecord(record, DICTIONARY)).toBe(
+      "[    0.000] <inf> zmk: took 5 us in scan"
+    );
+  });
+
+  it("should not format tagged arguments", () => {
+    const [record] = decodeLogRecords(RECORD, {
+      headerWords: 1,
+      argsTagged: true,
+    });
+    expect(formatLogRecord(record, DICTIONARY)).toBe(
+      "[    1.234] <wrn> zmk: <format 0x00001000> 0x0000002a 0x00000000"
+    );
+  });
+
+  it("should show addresses and raw arguments without one", () => {
+    const [record] = decodeLogRecords(RECORD);
+    expect(formatLogRecord(record)).toBe(
+      "[    1.234] <wrn> source 1: <format 0x00001000> 0x0000002a 0x00000000"
+    );
+  });
+});
+
+describe("readLogs", () => {
+  it("should read until no more records are waiting", async () => {
+    const requests: Request[] = [];
+    const responses = [
+      Response.create({ readLogs: { records: RECORD, more: true } }),
+      Response.create({ readLogs: { records: RECORD, dropped: 3 } }),
+    ];
+    const call = async (request: Request) => {
+      requests.push(request);
+      return responses[requests.length - 1];
+    };
+
+    const result = await readLogs(call);
+
+    expect(requests).toHaveLength(2);
+    expect(requests[0].readLogs).toBeDefined();
+    expect(result.records).toHaveLength(2);
+    expect(result.dropped).toBe(3);
+  });
+});
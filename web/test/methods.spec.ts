@@ -0,0 +1,146 @@
+/**
+ * Tests for the typed RPC methods
+ */
+
+import {
+  ErrorCode,
+  Notification,
+  Qos,
+  Request,
+  Response,
+} from "../src/proto/zmk/template/custom";
+import { REQUEST_TYPE_NAMES } from "../src/proto/zmk/template/custom_rpc";
+import { TemplateRPCError } from "../src/errors";
+import { templateMethods } from "../src/methods";
+import type { NotificationListener } from "../src/notifications";
+
+describe("templateMethods", () => {
+  it("should wrap the request and unwrap its response member", async () => {
+    const requests: Request[] = [];
+    const methods = templateMethods(async (request) => {
+      requests.push(request);
+      return Response.create({ state: { epoch: 1, version: 2 } });
+    });
+
+    const state = await methods.getStateSince({ epoch: 1 });
+
+    expect(requests[0].getStateSince?.epoch).toBe(1);
+    expect(state.version).toBe(2);
+  });
+
+  it("should throw error and mismatched responses", async () => {
+    const failing = templateMethods(async () =>
+      Response.create({ error: { code: ErrorCode.ERROR_CODE_BUSY } })
+    );
+    await expect(failing.sample({ value: 1 })).rejects.toThrow(
+      TemplateRPCError
+    );
+
+    const mismatched = templateMethods(async () =>
+      Response.create({ commit: { saved: 1 } })
+    );
+    await expect(mismatched.sample({ value: 1 })).rejects.toThrow(
+      "Unexpected response to sample request"
+    );
+  });
+
+  it("should wait for the job of a pending response", async () => {
+    let onSubscribe!: (listener: NotificationListener) => void;
+    const subscribed = new Promise<NotificationListener>((resolve) => {
+      onSubscribe = resolve;
+    });
+    const methods = templateMethods(
+      async () => Response.create({ pending: { jobId: 5 } }),
+      {
+        subscribe: (listener) => {
+          onSubscribe(listener);
+          return () => {};
+        },
+      }
+    );
+
+    const result = methods.sampleSlow({ delayMs: 10, value: 3 });
+    const listener = await subscribed;
+    listener(
+      Notification.create({
+        jobResult: {
+          jobId: 5,
+          done: true,
+          response: Response.encode(
+            Response.create({ sample: { value: "3" } })
+          ).finish(),
+        },
+      })
+    );
+
+    await expect(result).resolves.toEqual({ value: "3" });
+  });
+
+  it("should settle each batch entry on its own", async () => {
+    const requests: Request[] = [];
+    const methods = templateMethods(async (request) => {
+      requests.push(request);
+      return Response.create({
+        batch: {
+          responses: [
+            Response.encode(
+              Response.create({ sample: { value: "1" } })
+            ).finish(),
+            Response.encode(
+              Response.create({ error: { code: ErrorCode.ERROR_CODE_IO } })
+            ).finish(),
+          ],
+        },
+      });
+    });
+
+    const [sample, commit] = await methods.batch([
+      { method: "sample", request: { value: 1 } },
+      { method: "commit", request: {} },
+    ]);
+
+    const entries = requests[0].batch?.requests ?? [];
+    expect(entries).toHaveLength(2);
+    expect(Request.decode(entries[1]).commit).toBeDefined();
+    expect(sample).toEqual({ status: "fulfilled", value: { value: "1" } });
+    expect(commit.status).toBe("rejected");
+  });
+
+  it("should send the QoS with every request and batch entry", async () => {
+    const requests: Request[] = [];
+    const methods = templateMethods(
+      async (request) => {
+        requests.push(request);
+        return Response.create({ batch: { responses: [] } });
+      },
+      { qos: Qos.QOS_BULK }
+    );
+
+    await methods.batch([{ method: "getStats", request: {} }]);
+
+    expect(requests[0].qos).toBe(Qos.QOS_BULK);
+    const [encoded] = requests[0].batch?.requests ?? [];
+    expect(Request.decode(encoded).qos).toBe(Qos.QOS_BULK);
+  });
+
+  it("should stream pages until none is left", async () => {
+    let reads = 0;
+    const methods = templateMethods(async () =>
+      Response.create({ readLogs: { dropped: 1, more: ++reads < 3 } })
+    );
+
+    const pages = [];
+    for await (const page of methods.stream("readLogs", {})) {
+      pages.push(page);
+    }
+
+    expect(pages).toHaveLength(3);
+  });
+});
+
+describe("REQUEST_TYPE_NAMES", () => {
+  it("should name each request by its oneof tag", () => {
+    expect(REQUEST_TYPE_NAMES[1]).toBe("sample");
+    expect(REQUEST_TYPE_NAMES[19]).toBe("readLogs");
+  });
+});
@@ -0,0 +1,63 @@
+/**
+ * Tests for the notification hub
+ *
+ * jsdom has no web streams, so the Node implementation stands in for the
+ * Studio notification stream.
+ */
+
+import { ReadableStream } from "node:stream/web";
+import { Notification } from "../src/proto/zmk/template/custom";
+import { subscribeNotifications } from "../src/notifications";
+import { ZMKConnection } from "../src/rpc";
+
+function createConnection() {
+  let controller!: ReadableStreamDefaultController<unknown>;
+  const notification_readable = new ReadableStream({
+    start(c) {
+      controller = c;
+    },
+  });
+  const push = (subsystemIndex: number, notification: Notification) =>
+    controller.enqueue({
+      custom: {
+        customNotification: {
+          subsystemIndex,
+          payload: Notification.encode(notification).finish(),
+        },
+      },
+    });
+  const connection = { notification_readable } as unknown as ZMKConnection;
+  return { connection, push };
+}
+
+const flush = () => new Promise((resolve) => setTimeout(resolve, 0));
+
+describe("subscribeNotifications", () => {
+  it("should deliver decoded notifications of the subsystem", async () => {
+    const { connection, push } = createConnection();
+    const first = jest.fn();
+    const second = jest.fn();
+
+    subscribeNotifications(connection, 1, first);
+    subscribeNotifications(connection, 1, second);
+    push(1, Notification.create({ sample: { value: 42 } }));
+    push(2, Notification.create({ sample: { value: 7 } }));
+    await flush();
+
+    expect(first).toHaveBeenCalledTimes(1);
+    expect(first.mock.calls[0][0].sample.value).toBe(42);
+    expect(second).toHaveBeenCalledTimes(1);
+  });
+
+  it("should stop delivering after unsubscribe", async () => {
+    const { connection, push } = createConnection();
+    const listener = jest.fn();
+
+    const unsubscribe = subscribeNotifications(connection, 1, listener);
+    unsubscribe();
+    push(1, Notification.create({ sample: { value: 42 } }));
+    await flush();
+
+    expect(listener).not.toHaveBeenCalled();
+  });
+});
@@ -0,0 +1,86 @@
+/**
+ * Tests for the latency probe
+ */
+
+import { PingResponse } from "../src/proto/zmk/template/custom";
+import type {
+  DeepPartial,
+  PingRequest,
+} from "../src/proto/zmk/template/custom";
+import {
+  percentile,
+  pingHistogram,
+  runPings,
+  summarizePings,
+} from "../src/ping";
+
+describe("percentile", () => {
+  it("should pick the nearest rank", () => {
+    const sorted = Array.from({ length: 100 }, (_, i) => i + 1);
+    expect(percentile(sorted, 0.5)).toBe(50);
+    expect(percentile(sorted, 0.99)).toBe(99);
+    expect(percentile([], 0.5)).toBe(0);
+  });
+});
+
+describe("runPings", () => {
+  it("should measure each round trip from the echoed host time", async () => {
+    let now = 0;
+    let inFlight = 0;
+    let maxInFlight = 0;
+    const ping = async (request: DeepPartial<PingRequest>) => {
+      inFlight++;
+      maxInFlight = Math.max(maxInFlight, inFlight);
+      await Promise.resolve();
+      now += 2;
+      inFlight--;
+      return PingResponse.create({
+        ...request,
+        deviceCycles: now * 1000,
+        cyclesPerSecond: 1_000_000,
+      });
+    };
+
+    const run = await runPings(
+      ping,
+      { count: 10, inFlight: 2, payloadSize: 4 },
+      () => now
+    );
+
+    expect(run.roundTripsMs).toHaveLength(10);
+    expect(run.lost).toBe(0);
+    expect(maxInFlight).toBe(2);
+    expect(run.elapsedMs).toBe(20);
+    expect(run.deviceElapsedMs).toBe(18);
+
+    const summary = summarizePings(run);
+    expect(summary.pingsPerSecond).toBe(500);
+    expect(summary.payloadBytesPerSecond).toBe(4000);
+  });
+
+  it("should count failed and mismatched pings as lost", async () => {
+    let calls = 0;
+    const ping = async (request: DeepPartial<PingRequest>) => {
+      if (++calls === 1) throw new Error("timeout");
+      return PingResponse.create({ ...request, sequence: 99 });
+    };
+
+    const run = await runPings(ping, { count: 2 }, () => 0);
+
+    expect(run.lost).toBe(2);
+    expect(run.roundTripsMs).toHaveLength(0);
+  });
+});
+
+describe("pingHistogram", () => {
+  it("should spread round trips up to the slowest", () => {
+    const run = {
+      roundTripsMs: [1, 1, 2, 4],
+      lost: 0,
+      payloadSize: 0,
+      elapsedMs: 8,
+      deviceElapsedMs: 0,
+    };
+    expect(pingHistogram(run, 4)).toEqual([0, 2, 1, 1]);
+  });
+});
@@ -0,0 +1,98 @@
+/**
+ * Tests for the module state sync helpers
+ */
+
+import {
+  GetStateResponse,
+  Request,
+  Response,
+} from "../src/proto/zmk/template/custom";
+import {
+  commitState,
+  mergeState,
+  syncState,
+  updateState,
+} from "../src/state";
+
+describe("mergeState", () => {
+  const current = {
+    epoch: 7,
+    version: 3,
+    state: { enabled: true, brightness: 50, mode: 0, label: "Template" },
+  };
+
+  it("should overlay the changed fields on the local copy", () => {
+    const merged = mergeState(
+      current,
+      GetStateResponse.create({
+        epoch: 7,
+        version: 4,
+        state: { brightness: 80 },
+      })
+    );
+
+    expect(merged.version).toBe(4);
+    expect(merged.state).toEqual({ ...current.state, brightness: 80 });
+  });
+
+  it("should replace the copy on a full response or a new epoch", () => {
+    const full = mergeState(
+      current,
+      GetStateResponse.create({
+        epoch: 7,
+        version: 9,
+        full: true,
+        state: { enabled: false },
+      })
+    );
+    expect(full.state).toEqual({ enabled: false });
+
+    const rebooted = mergeState(
+      current,
+      GetStateResponse.create({ epoch: 8, version: 1, state: { mode: 2 } })
+    );
+    expect(rebooted.state).toEqual({ mode: 2 });
+  });
+});
+
+describe("syncState", () => {
+  it("should send the version of the local copy", async () => {
+    const requests: Request[] = [];
+    const call = async (request: Request) => {
+      requests.push(request);
+      return Response.create({
+        state: { epoch: 7, version: 5, state: { label: "Renamed" } },
+      });
+    };
+
+    const synced = await syncState(call, {
+      epoch: 7,
+      version: 3,
+      state: { label: "Template", brightness: 50 },
+    });
+
+    expect(requests[0].getStateSince).toEqual({ epoch: 7, version: 3 });
+    expect(synced).toEqual({
+      epoch: 7,
+      version: 5,
+      state: { label: "Renamed", brightness: 50 },
+    });
+  });
+
+  it("should turn error responses into exceptions", async () => {
+    const call = async () =>
+      Response.create({ error: { message: "Failed to process request" } });
+
+    const result = updateState(call, null, { brightness: 500 });
+    await expect(result).rejects.toThrow("Failed to process request");
+  });
+});
+
+describe("commitState", () => {
+  it("should return the number of saved fields", async () => {
+    const call = async (request: Request) =>
+      request.commit ? Response.create({ commit: { saved: 2 } }) : null;
+
+    expect(await commitState(call)).toBe(2);
+  });
+});
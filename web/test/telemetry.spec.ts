@@ -0,0 +1,98 @@
+/**
+ * Tests for the telemetry store
+ */
+
+import { KeyEventBatch, Notification } from "../src/proto/zmk/template/custom";
+import { RingBuffer, TelemetryStore } from "../src/telemetry";
+
+describe("RingBuffer", () => {
+  it("should keep the newest values once full", () => {
+    const ring = new RingBuffer(3);
+    [1, 2, 3, 4, 5].forEach((value) => ring.push(value));
+
+    expect(ring.length).toBe(3);
+    expect([ring.at(0), ring.at(1), ring.at(2)]).toEqual([3, 4, 5]);
+    expect(ring.at(3)).toBeUndefined();
+    expect(ring.last()).toBe(5);
+    expect(ring.countSince(4)).toBe(2);
+
+    ring.clear();
+    expect(ring.last()).toBeUndefined();
+  });
+});
+
+describe("TelemetryStore", () => {
+  // Frames run when the test says so
+  const createStore = () => {
+    const frames: (() => void)[] = [];
+    let now = 0;
+    const store = new TelemetryStore({
+      historySize: 16,
+      schedule: (callback) => frames.push(callback),
+      now: () => now,
+    });
+    const runFrames = () => frames.splice(0).forEach((frame) => frame());
+    const advance = (ms: number) => (now += ms);
+    return { store, runFrames, advance };
+  };
+
+  // Press position 1 twice and position 2 once
+  const keyEvents = Notification.create({
+    keyEvents: KeyEventBatch.create({
+      startMs: 0,
+      events: new Uint8Array([3, 0, 2, 1, 3, 1, 5, 1]),
+    }),
+  });
+
+  beforeEach(() => jest.useFakeTimers());
+  afterEach(() => jest.useRealTimers());
+
+  it("should notify subscribers once per frame", () => {
+    const { store, runFrames } = createStore();
+    const listener = jest.fn();
+    store.subscribe(listener);
+
+    const version = store.getSnapshot();
+    for (let i = 0; i < 10; i++) {
+      store.addNotification(Notification.create({ sample: { value: i } }));
+    }
+    expect(listener).not.toHaveBeenCalled();
+
+    runFrames();
+    expect(listener).toHaveBeenCalledTimes(1);
+    expect(store.getSnapshot()).toBe(version + 1);
+    expect(store.samples.last()).toBe(9);
+  });
+
+  it("should count key presses and their rate", () => {
+    const { store, runFrames, advance } = createStore();
+    const listener = jest.fn();
+    store.subscribe(listener);
+
+    store.addNotification(keyEvents);
+    expect(store.keys.counts[1]).toBe(2);
+    expect(store.keys.counts[2]).toBe(1);
+    expect(store.rate(store.pressTimes)).toBe(3);
+    expect(store.rate(store.notificationTimes)).toBe(1);
+    runFrames();
+
+    // Subscribers hear about the rate dropping once the window has passed
+    advance(1001);
+    jest.advanceTimersByTime(1000);
+    runFrames();
+    expect(listener).toHaveBeenCalledTimes(2);
+    expect(store.rate(store.pressTimes)).toBe(0);
+  });
+
+  it("should replace and clear the press counts", () => {
+    const { store } = createStore();
+    store.addNotification(keyEvents);
+
+    store.setKeyCounts([4, 0, 7]);
+    expect(store.keys.max).toBe(7);
+
+    store.clearKeys();
+    expect(store.keys.max).toBe(0);
+    expect(store.pressTimes.length).toBe(0);
+  });
+});
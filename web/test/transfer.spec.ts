@@ -0,0 +1,117 @@
+/**
+ * Tests for the chunked transfer helpers
+ *
+ * The device is replaced by a small in-memory fake that implements the
+ * transfer requests the same way the firmware does.
+ */
+
+import {
+  Request,
+  Response,
+  TransferResource,
+} from "../src/proto/zmk/template/custom";
+import { crc32, readTransfer, writeTransfer } from "../src/transfer";
+
+const MAX_CHUNK_SIZE = 128;
+
+function createFakeDevice() {
+  let blob = new Uint8Array(0);
+  let staging = new Uint8Array(0);
+  let transferId = 0;
+  let inFlight = 0;
+  let maxInFlight = 0;
+
+  const call = async (request: Request): Promise<Response> => {
+    inFlight++;
+    maxInFlight = Math.max(maxInFlight, inFlight);
+    await new Promise((resolve) => setTimeout(resolve, 0));
+    inFlight--;
+
+    if (request.beginTransfer) {
+      transferId++;
+      const size = request.beginTransfer.direction
+        ? request.beginTransfer.size
+        : blob.length;
+      staging = new Uint8Array(size);
+      return Response.create({
+        beginTransfer: {
+          transferId,
+          size,
+          maxChunkSize: MAX_CHUNK_SIZE,
+          crc32: crc32(blob),
+        },
+      });
+    }
+    if (request.readChunk) {
+      const { offset, length } = request.readChunk;
+      const data = blob.slice(offset, offset + length);
+      return Response.create({
+        readChunk: { transferId, offset, data, crc32: crc32(data) },
+      });
+    }
+    if (request.writeChunk) {
+      const { offset, data } = request.writeChunk;
+      staging.set(data, offset);
+      return Response.create({
+        writeChunk: { transferId, offset, length: data.length },
+      });
+    }
+    if (request.endTransfer) {
+      const { crc32: expected } = request.endTransfer;
+      if (expected && crc32(staging) === expected) {
+        blob = staging;
+      }
+      return Response.create({ endTransfer: { transferId } });
+    }
+    return Response.create({ error: { message: "Unsupported" } });
+  };
+
+  return { call, getMaxInFlight: () => maxInFlight };
+}
+
+describe("crc32", () => {
+  it("should match the IEEE check value", () => {
+    const data = Uint8Array.from("123456789", (c) => c.charCodeAt(0));
+    expect(crc32(data)).toBe(0xcbf43926);
+  });
+
+  it("should support incremental updates", () => {
+    const data = Uint8Array.from("123456789", (c) => c.charCodeAt(0));
+    expect(crc32(data.subarray(4), crc32(data.subarray(0, 4)))).toBe(
+      crc32(data)
+    );
+  });
+});
+
+describe("Chunked transfer", () => {
+  it("should write and read back a blob larger than one chunk", async () => {
+    const device = createFakeDevice();
+    const data = Uint8Array.from({ length: 1000 }, (_, i) => i & 0xff);
+
+    await writeTransfer(
+      device.call,
+      TransferResource.TRANSFER_RESOURCE_SCRATCH,
+      data
+    );
+    const read = await readTransfer(
+      device.call,
+      TransferResource.TRANSFER_RESOURCE_SCRATCH
+    );
+
+    expect(read).toEqual(data);
+  });
+
+  it("should keep several chunk requests in flight", async () => {
+    const device = createFakeDevice();
+    const data = new Uint8Array(MAX_CHUNK_SIZE * 8);
+
+    await writeTransfer(
+      device.call,
+      TransferResource.TRANSFER_RESOURCE_SCRATCH,
+      data,
+      { pipelineDepth: 4 }
+    );
+
+    expect(device.getMaxInFlight()).toBe(4);
+  });
+});
@@ -0,0 +1,38 @@
+/**
+ * Tests for key usage counters
+ */
+
+import { Request, Response } from "../src/proto/zmk/template/custom";
+import { decodeUsageCounts, fetchUsageCounts } from "../src/usage";
+
+describe("decodeUsageCounts", () => {
+  it("should read little-endian uint16 counters", () => {
+    const bytes = Uint8Array.from([1, 0, 0x34, 0x12, 0xff, 0xff]);
+    expect(decodeUsageCounts(bytes)).toEqual([1, 0x1234, 65535]);
+  });
+
+  it("should ignore a trailing odd byte", () => {
+    expect(decodeUsageCounts(Uint8Array.from([2, 0, 7]))).toEqual([2]);
+  });
+});
+
+describe("fetchUsageCounts", () => {
+  it("should pass the reset flag and decode the counters", async () => {
+    const requests: Request[] = [];
+    const call = async (request: Request) => {
+      requests.push(request);
+      return Response.create({
+        usageStats: { counts: Uint8Array.from([0, 0, 5, 0]) },
+      });
+    };
+
+    await expect(fetchUsageCounts(call, true)).resolves.toEqual([0, 5]);
+    expect(requests[0].getUsageStats).toEqual({ reset: true });
+  });
+
+  it("should turn error responses into exceptions", async () => {
+    const call = async () =>
+      Response.create({ error: { message: "Not supported" } });
+    await expect(fetchUsageCounts(call)).rejects.toThrow("Not supported");
+  });
+});